@@ -1,12 +1,231 @@
 #ifndef SAKURAJIN_RS232_HPP_INCLUDED
 #define SAKURAJIN_RS232_HPP_INCLUDED
 
+#include "rs232_chunkrope.hpp"
+#include "rs232_framing.hpp"
+#include "rs232_hotplug.hpp"
 #include "rs232_native.hpp"
+#include "rs232_reactor.hpp"
+#include "rs232_ringbuffer.hpp"
+#include "rs232_transmitqueue.hpp"
 
+#include <condition_variable>
+#include <deque>
 #include <future>
 
 namespace sakurajin {
 
+    /**
+     * @brief An enum to define what happens if a bounded receive or transmit buffer is full
+     */
+    enum overflowPolicy {
+        /**
+         * @brief Wait until there is enough space
+         * Print blocks the calling thread. On the receive side the work thread stops reading from the device, so the data stays
+         * in the kernel buffer and flow control (if enabled) pauses the sender.
+         */
+        blockOnOverflow,
+        /// Drop the oldest buffered data to make room for the new data
+        dropOldest,
+        /// Drop the new data that does not fit
+        dropNewest,
+        /**
+         * @brief Let the call fail without changing the buffer
+         * Print returns false. The receive side cannot fail a call, there this behaves like dropNewest.
+         */
+        failOnOverflow
+    };
+
+    /**
+     * @brief Statistics about the bounded buffers of an RS232 object
+     */
+    struct RS232_bufferStats {
+        /// The number of received bytes that were dropped because the receive buffer was full
+        uint64_t droppedReceiveBytes = 0;
+        /// The number of bytes passed to Print that were dropped because the transmit buffer was full
+        uint64_t droppedTransmitBytes = 0;
+        /// The number of calls to Print that failed because the transmit buffer was full
+        uint64_t failedPrints = 0;
+        /// The number of bytes that were passed to Print but are not written yet
+        size_t pendingTransmitBytes = 0;
+    };
+
+    /**
+     * @brief A chunk of data that was received from one of the devices in fan in mode
+     */
+    struct RS232_chunk {
+        /// The index of the device the data was received from, see RS232::getNativeDevice
+        size_t deviceIndex = 0;
+        /// The time the data was read from the device
+        std::chrono::steady_clock::time_point timestamp;
+        /// The received data
+        std::string data;
+    };
+
+    /**
+     * @brief A function that checks if the right device is connected to a port
+     * It is called right after the port was opened and may send and receive data with the raw functions of the device.
+     * @warning the probes of different devices run at the same time in different threads, each with its own copy of the function.
+     * @return true if the device should be used, false if the port should be closed again
+     */
+    using RS232_probe = std::function<bool(RS232_native& device)>;
+
+    /**
+     * @brief Create a probe that sends a request and expects a response
+     * @param request the data that is written to the device
+     * @param expectedResponse the device is accepted once the received data contains this
+     * @param timeout the maximum time for sending the request and receiving the response
+     */
+    RS232_EXPORT_MACRO RS232_probe makeResponseProbe(std::string               request,
+                                                     std::string               expectedResponse,
+                                                     std::chrono::milliseconds timeout = std::chrono::milliseconds(200));
+
+    /**
+     * @brief Additional settings of the RS232 wrapper class
+     * These can only be set when constructing the object since they change how the work thread stores and handles the data.
+     */
+    struct RS232_settings {
+        /**
+         * @brief The capacity of the lock free receive ring in bytes
+         * If this is 0 the received data is stored in the read buffer string and the retrieve functions can be used.
+         * Otherwise the received data is stored in a single producer single consumer ring with (at least) this capacity.
+         * That ring can be drained with RS232::retrieveFromRing without locking or allocating anything.
+         */
+        size_t receiveRingCapacity = 0;
+
+        /**
+         * @brief Store the received data in a rope of reference counted chunks
+         * If this is true the work thread appends every received chunk to a RS232_chunkRope instead of the read buffer string.
+         * Use RS232::peek to look at the received data without copying it and RS232::consume to remove it once it was handled.
+         * The retrieve functions that search the read buffer (matches, delimiters) do not return data in this mode.
+         * @note this is ignored if the receive ring is used.
+         */
+        bool receiveRope = false;
+
+        /**
+         * @brief The reactor that should serve the object
+         * If this is nullptr the object starts its own work thread.
+         * Otherwise the object is registered with the reactor and shares its threads with all other objects using the same reactor.
+         */
+        std::shared_ptr<RS232_reactor> reactor = nullptr;
+
+        /**
+         * @brief The decoder for binary framing protocols
+         * If this is set, the work thread feeds all received data into the decoder and stores only the complete, decoded frames.
+         * They can be retrieved with RS232::retrieveDecodedFrames, the read buffer and the receive ring stay empty.
+         * @warning the decoder keeps the state of the current frame, so every RS232 object needs its own decoder.
+         */
+        std::shared_ptr<RS232_frameDecoder> frameDecoder = nullptr;
+
+        /**
+         * @brief Use a separate thread for writing to the device
+         * By default a single work thread handles reading and writing. Writes are done without blocking, so even then a large
+         * message does not stop the reception. If this is true, reading and writing are done by two independent threads instead.
+         * @note on windows the ports do not support non blocking writes, a write returns after its timeout of about 1ms with the
+         * bytes the driver accepted. A single write can therefore delay the reception by up to 1ms without a separate write thread.
+         * @note this is ignored if a reactor is used.
+         */
+        bool separateWriteThread = false;
+
+        /**
+         * @brief An arbitrary bit rate for all devices
+         * If this is not 0 it overrides the Baudrate passed to the constructor.
+         * Use getNativeDevice(i)->getBaudrate() to get the rate that is actually used by a device.
+         */
+        uint32_t customBaudrate = 0;
+
+        /**
+         * @brief Enable the low latency mode of all devices
+         * This reduces the delay of the tty layer and the latency timer of usb serial adapters, see RS232_native::setLowLatency.
+         * Use getNativeDevice(i)->getLatencyInfo() to get the settings that are actually used by a device.
+         */
+        bool lowLatency = false;
+
+        /**
+         * @brief The configuration of the serial line for all devices
+         * This sets the data bits, parity, stop bits and flow control, by default 8N1 without flow control is used.
+         */
+        lineConfiguration lineConfig;
+
+        /**
+         * @brief The maximum number of received bytes that are buffered until they are retrieved
+         * If this is 0 the buffer grows without limit.
+         * This limits the read buffer string or with a frame decoder the total size of the decoded frames.
+         * The receive ring is always limited by its own capacity, so this value is ignored if the ring is used.
+         * The receive rope is limited like the read buffer string.
+         */
+        size_t receiveCapacity = 0;
+
+        /**
+         * @brief What happens if a received chunk does not fit into the receive buffer
+         * @note with the receive ring dropOldest behaves like dropNewest, since only the consumer may remove data from it.
+         */
+        overflowPolicy receiveOverflowPolicy = blockOnOverflow;
+
+        /**
+         * @brief The maximum number of bytes that were passed to Print but are not written yet
+         * If this is 0 the transmit buffer grows without limit.
+         * A single message that is larger than the capacity is only accepted by blockOnOverflow and only once nothing else is
+         * pending, so it is never blocked forever.
+         */
+        size_t transmitCapacity = 0;
+
+        /**
+         * @brief What happens if a message passed to Print does not fit into the transmit buffer
+         * With dropOldest the message is always accepted and the work thread drops the oldest messages that were not started yet.
+         * Messages are only dropped as a whole and the batch that is being written is always finished, so the pending data can
+         * exceed the capacity by that batch. Only the work thread may remove data from the lock free transmit queue, so with this
+         * policy the memory use can also briefly exceed the capacity if many messages are printed faster than the work thread runs.
+         */
+        overflowPolicy transmitOverflowPolicy = blockOnOverflow;
+
+        /**
+         * @brief Reconnect automatically if the current device is lost
+         * If the current device reports an error (for example because it was unplugged), the object fails over to the next
+         * available device in its list. If no device is available, it reconnects as soon as one of its devices appears again.
+         * This also applies to devices that are missing when the object is constructed.
+         * On linux device changes are detected with the shared RS232_hotplugMonitor, on other platforms the devices are checked
+         * every 500ms while no device is connected.
+         * Data that was printed but not written yet is kept and written to the new device.
+         * @note devices that were disconnected with DisconnectAll are not reconnected automatically.
+         */
+        bool autoReconnect = true;
+
+        /**
+         * @brief The maximum time for opening (and probing) a device
+         * Connect opens all devices at the same time, so it never takes much longer than this.
+         * A device that takes longer is treated like a device that could not be opened and closed once its attempt finishes.
+         */
+        std::chrono::milliseconds connectTimeout = std::chrono::milliseconds(2000);
+
+        /**
+         * @brief The optional probe that selects the right device
+         * If this is set, every device that was opened is only used if the probe accepts it, otherwise it is closed again.
+         * See makeResponseProbe for a probe that sends a request and waits for the expected response.
+         */
+        RS232_probe probe = nullptr;
+
+        /**
+         * @brief Receive from all connected devices instead of only the current one
+         * The work thread waits for all connected devices with a single waitForEvents call. Every read is stored as a chunk that is
+         * tagged with the index of its device and the time it was read. All chunks form one stream in the order they were read
+         * and can be retrieved with RS232::retrieveChunks. The receive capacity limits the total size of the stored chunks.
+         * Writes still go to the current device and lost devices are reconnected like the current one.
+         * @note the read buffer, the receive ring and the frame decoder are not used in this mode.
+         * @note the object always uses its own work thread in this mode, the reactor is ignored.
+         */
+        bool fanIn = false;
+
+        /**
+         * @brief Close the devices that Connect opened but did not select
+         * Connect opens all devices in parallel and by default all of them stay open, so they can be used with getNativeDevice or
+         * Broadcast. If this is set, only the current device stays open and the other ports are released for other programs.
+         * Devices that were connected before the call are not closed.
+         * @note this is ignored in fan in mode, since all devices are read in that mode.
+         */
+        bool closeUnusedDevices = false;
+    };
+
     /**
      * @brief The RS232 class is a wrapper class for the RS232_native class.
      * It can contain many RS232_native objects and allows the user to switch between them.
@@ -17,6 +236,8 @@ namespace sakurajin {
      */
     class RS232_EXPORT_MACRO RS232 {
       private:
+        friend class RS232_reactor;
+
         /**
          * @brief The list of devices that are used for the connection
          * This wrapper class uses a list of devices to allow the user to switch between devices without having to close the connection.
@@ -45,21 +266,408 @@ namespace sakurajin {
         std::future<void> workThread;
         std::atomic<bool> stopThread = false;
 
+        /**
+         * @brief The optional write thread and its wakeup handle
+         * These are only used if separateWriteThread is set in the settings.
+         */
+        std::future<void> writeThread;
+        RS232_wakeup      writeWakeup;
+
+        /**
+         * @brief The wakeup handle of the work thread
+         * The work thread blocks until the current device has data or this is notified.
+         * Print notifies it when new data has to be written and the destructor when the thread should stop.
+         */
+        RS232_wakeup wakeup;
+
+        /**
+         * @brief The reactor that serves this object, nullptr if the object uses its own work thread
+         */
+        std::shared_ptr<RS232_reactor> reactor;
+
+        /**
+         * @brief The wakeup handle of the thread that serves this object
+         * This is either the own wakeup handle or the one of the reactor thread the object is registered with.
+         */
+        RS232_wakeup* workerWakeup = &wakeup;
+
+        /**
+         * @brief The wakeup handle of the thread that handles the read stage
+         * That thread also reconnects the devices, so it is notified by the hot plug monitor.
+         */
+        RS232_wakeup* readerWakeup = &wakeup;
+
+        /**
+         * @brief The state of the automatic reconnection
+         * autoReconnect is only set in the constructor.
+         * reconnectPending is set if no device could be connected in the constructor or once the current device is lost,
+         * and reset once a device is connected again.
+         * devicesChanged is set by the hot plug monitor (or when the device is lost) to trigger a new connection attempt.
+         * lastReconnectAttempt is only used without a hot plug monitor and only accessed by the thread that handles the read stage.
+         */
+        bool                                  autoReconnect = false;
+        std::shared_ptr<RS232_hotplugMonitor> hotplugMonitor;
+        std::atomic<bool>                     reconnectPending = false;
+        std::atomic<bool>                     devicesChanged   = false;
+        std::chrono::steady_clock::time_point lastReconnectAttempt;
+
+        /**
+         * @brief The state of the parallel connection attempts
+         * connectMutex serializes calls to Connect, connectTimeout, probe and closeUnusedDevices are only set in the constructor.
+         * errorStream is the stream that was given to the constructor, the errors of all attempts (including the ones that
+         * reconnect in the background) are written to it once the attempt is evaluated.
+         * connectsInFlight has a flag for every device that is set while a thread opens or probes it. The flags are shared with
+         * these threads, so a device whose attempt timed out is skipped by all later attempts until its thread finished.
+         */
+        struct connectAttempt;
+        std::mutex                                      connectMutex;
+        std::chrono::milliseconds                       connectTimeout = std::chrono::milliseconds(2000);
+        RS232_probe                                     probe;
+        std::shared_ptr<std::vector<std::atomic<bool>>> connectsInFlight;
+        bool                                            closeUnusedDevices = false;
+        std::ostream*                                   errorStream        = &std::cerr;
+
+        /**
+         * @brief The connection attempt that runs in the background to reconnect the devices
+         * It is only accessed by the thread that handles the read stage (and the destructor once all threads stopped).
+         */
+        std::shared_ptr<connectAttempt> reconnectAttempt;
+
+        /**
+         * @brief The state of the fan in mode
+         * fanIn is only set in the constructor.
+         * The wait entries and the device indices are reused for every wait and only accessed by the thread that handles the read
+         * stage, just like the pending chunks that could not be moved to the received chunks yet.
+         * The received chunks and their total size are protected by receivedChunksMutex.
+         */
+        bool                     fanIn = false;
+        std::vector<ioWaitEntry> fanInEntries;
+        std::vector<size_t>      fanInIndices;
+        std::vector<RS232_chunk> pendingChunks;
+        std::vector<RS232_chunk> receivedChunks;
+        size_t                   receivedChunksSize = 0;
+        std::mutex               receivedChunksMutex;
+
+        /**
+         * @brief A broadcast message that still has to be written to one device
+         * All devices share the same buffer, each job only keeps its own write position.
+         */
+        struct broadcastJob {
+            std::shared_ptr<const std::string> data;
+            size_t                             offset = 0;
+            std::promise<bool>                 completion;
+        };
+
+        /**
+         * @brief The broadcast messages of every device, in the same order as rs232Devices
+         * They are protected by broadcastMutex and written by the thread that handles the write stage.
+         * pendingBroadcasts counts all jobs, so the work thread does not have to lock the mutex if there are none.
+         */
+        std::vector<std::deque<broadcastJob>> broadcastJobs;
+        std::mutex                            broadcastMutex;
+        std::atomic<size_t>                   pendingBroadcasts = 0;
+
         std::string       readBuffer;
         std::timed_mutex  readBufferMutex;
         std::atomic<bool> readBufferHasData = false;
 
-        std::string       writeBuffer;
-        std::timed_mutex  writeBufferMutex;
-        std::atomic<bool> writeBufferHasData = false;
+        /**
+         * @brief The position in the read buffer where the next resumable search starts
+         * Everything in front of this position was already searched and can never be part of a match.
+         * This is only used by retrieveAllMatches with a maximum match length and reset whenever the front of the read buffer changes.
+         */
+        size_t matchCursor = 0;
+
+        /**
+         * @brief The maximum number of bytes the work thread reads from the device in a single call
+         */
+        std::atomic<size_t> readChunkSize = 4096;
+
+        /**
+         * @brief The buffer the work thread reads into
+         * It is reused for every read and only reallocated if the chunk size changes.
+         */
+        std::vector<char> readChunk;
+
+        /**
+         * @brief Read data that could not be moved into the read buffer yet
+         * If the read buffer is locked by one of the retrieve functions for too long, the data is stored here and moved during the
+         * next call to work. This is only ever accessed by the work thread.
+         */
+        std::string queuedBuffer;
+
+        /**
+         * @brief Set while the thread that handles the read stage has data it could not store yet
+         * The data can wait because the receive store is full or because its mutex was locked. The retrieve functions wake up
+         * the thread once they released the store, so it does not have to poll until the data fits.
+         * The guard notifies when it is destroyed, so it is created before the store is locked and notifies after it was released.
+         */
+        std::atomic<bool> receiveSpaceWanted = false;
+        struct receiveSpaceGuard;
+
+        /**
+         * @brief The optional lock free receive store
+         * If this is set, all received data is pushed into this ring instead of the read buffer string.
+         */
+        std::unique_ptr<RS232_ringBuffer> receiveRing;
+
+        /**
+         * @brief The optional receive store of reference counted chunks
+         * If this is set, all received data is appended to this rope instead of the read buffer string.
+         */
+        std::unique_ptr<RS232_chunkRope> receiveRope;
+
+        /**
+         * @brief The optional decoder for binary framing protocols
+         */
+        std::shared_ptr<RS232_frameDecoder> frameDecoder;
+
+        /**
+         * @brief The complete frames that were decoded but not retrieved yet
+         */
+        std::vector<std::string> decodedFrames;
+        std::mutex               decodedFramesMutex;
+
+        /**
+         * @brief The total size of all decoded frames, protected by decodedFramesMutex
+         */
+        size_t decodedFramesSize = 0;
+
+        /**
+         * @brief Decoded frames that could not be moved to decodedFrames yet because the mutex was locked
+         * This is only accessed by the work thread.
+         */
+        std::vector<std::string> pendingFrames;
+
+        /**
+         * @brief The messages that should be written to the current device
+         * Print pushes into this queue without locking, the work thread drains all queued messages at once.
+         */
+        RS232_transmitQueue transmitQueue;
+
+        /**
+         * @brief The buffer the work thread collects the queued messages in before writing them
+         * It is reused for every write so its capacity is kept.
+         */
+        std::string writeBatch;
+
+        /**
+         * @brief The number of bytes of the write batch that were already written
+         */
+        size_t writeOffset = 0;
+
+        /**
+         * @brief The limits and policies of the receive and transmit buffers
+         * These are only set in the constructor.
+         */
+        size_t         receiveCapacity  = 0;
+        overflowPolicy receivePolicy    = blockOnOverflow;
+        size_t         transmitCapacity = 0;
+        overflowPolicy transmitPolicy   = blockOnOverflow;
+
+        /**
+         * @brief The overflow counters that are returned by getBufferStats
+         */
+        std::atomic<uint64_t> droppedReceiveBytes  = 0;
+        std::atomic<uint64_t> droppedTransmitBytes = 0;
+        std::atomic<uint64_t> failedPrints         = 0;
+
+        /**
+         * @brief The number of bytes that were passed to Print but are not written yet
+         * Print adds the size of each message, the work thread subtracts everything it writes or drops.
+         */
+        std::atomic<size_t> transmitPending = 0;
+
+        /**
+         * @brief Used to let Print wait for space in the transmit buffer with the blockOnOverflow policy
+         * The work thread only notifies the condition if there are waiting threads.
+         */
+        std::mutex              transmitSpaceMutex;
+        std::condition_variable transmitSpaceCondition;
+        std::atomic<size_t>     transmitWaiters = 0;
 
         /**
          * @brief The function that is executed by the work thread
-         * It performs the actual read/write operations constantly in the background.
+         * It performs the actual read/write operations in the background.
+         * Each call blocks until the current device can be read from, queued data can be written or the thread is woken up.
          * This function only does one loop iteration and then returns.
          * It should be called in a loop to keep the query system running.
+         * @param stages the events (ioReadable and/or ioWritable) this thread is responsible for
+         * @param threadWakeup the wakeup handle of the calling thread
          */
-        void work();
+        void work(int stages, RS232_wakeup& threadWakeup);
+
+        /**
+         * @brief The read stage in fan in mode
+         * This waits for the current device like work does and additionally for all other connected devices.
+         * @param stages the events (ioReadable and/or ioWritable) this thread is responsible for
+         * @param threadWakeup the wakeup handle of the calling thread
+         */
+        void workFanIn(int stages, RS232_wakeup& threadWakeup);
+
+        /**
+         * @brief Move the pending chunks to the received chunks if the consumer does not hold the mutex
+         * This is only called by the thread that handles the read stage.
+         */
+        void publishChunks();
+
+        /**
+         * @brief Add a wait entry for every device that has broadcast messages to write
+         * This is called by the thread that handles the write stage in addition to prepareWait.
+         * Messages for devices that are not connected anymore are failed.
+         * @param indices the index of the device of every added entry is appended to this
+         * @param entries the wait entries are appended to this
+         */
+        void prepareBroadcastWait(std::vector<size_t>& indices, std::vector<ioWaitEntry>& entries);
+
+        /**
+         * @brief Write the broadcast messages to all devices that are writable
+         * @param indices the device indices that were returned by prepareBroadcastWait
+         * @param entries the wait entries that were returned by prepareBroadcastWait
+         * @param count the number of entries
+         */
+        void handleBroadcastEvents(const size_t* indices, const ioWaitEntry* entries, size_t count);
+
+        /**
+         * @brief Write as much of the broadcast messages of a device as possible without blocking
+         */
+        void writeBroadcasts(size_t index);
+
+        /**
+         * @brief Report all broadcast messages of a device as failed, the caller has to hold the broadcastMutex
+         */
+        void failBroadcasts(size_t index);
+
+        /**
+         * @brief Check if a broadcast message is partially written to a device
+         * No other data may be written to the device until that message is complete.
+         */
+        bool broadcastStarted(size_t index);
+
+        /**
+         * @brief Determine what the work thread should wait for
+         * This is the first half of work, it is also used by the reactor to wait for many objects at once.
+         * @param transferDevice is set to the device that should be waited for or nullptr if no device is usable
+         * @param entry is set to the wait entry for that device
+         * @param stages the events (ioReadable and/or ioWritable) the calling thread is responsible for
+         * @return std::chrono::milliseconds the maximum time that should be waited
+         */
+        std::chrono::milliseconds prepareWait(std::shared_ptr<RS232_native>& transferDevice, ioWaitEntry& entry, int stages);
+
+        /**
+         * @brief Perform the actual read/write operations after the wait returned
+         * This is the second half of work, it is also used by the reactor.
+         * @param transferDevice the device that was returned by prepareWait
+         * @param returned the events that occurred on the device
+         * @param stages the events (ioReadable and/or ioWritable) the calling thread is responsible for
+         */
+        void handleEvents(const std::shared_ptr<RS232_native>& transferDevice, int returned, int stages);
+
+        /**
+         * @brief The write stage, writes as much of the queued data as possible without blocking
+         */
+        void handleWrite(const std::shared_ptr<RS232_native>& transferDevice);
+
+        /**
+         * @brief The read stage, reads the next chunk and publishes it
+         */
+        void handleRead(const std::shared_ptr<RS232_native>& transferDevice, int returned);
+
+        /**
+         * @brief Move the received data into the receive store that is used by this object
+         * This is only called by the work thread.
+         * If the data cannot be stored immediately it is kept in the queued buffer and tried again during the next call.
+         * @param data the data that was received
+         * @param length the number of bytes in data
+         */
+        void publishReadData(const char* data, size_t length);
+
+        /**
+         * @brief Append received data to the read buffer while respecting the receive capacity
+         * The caller has to hold the readBufferMutex.
+         * @param data the received data
+         * @param length the number of bytes in data
+         * @return size_t the number of bytes that were stored or dropped, the rest has to be kept for the next try
+         */
+        size_t storeReceivedData(const char* data, size_t length);
+
+        /**
+         * @brief Append received data to the receive rope while respecting the receive capacity
+         * @param data the received data
+         * @param length the number of bytes in data
+         * @return size_t the number of bytes that were stored or dropped, the rest has to be kept for the next try
+         */
+        size_t storeInRope(const char* data, size_t length);
+
+        /**
+         * @brief Move the pending frames to the decoded frames while respecting the receive capacity
+         * The caller has to hold the decodedFramesMutex.
+         */
+        void storeDecodedFrames();
+
+        /**
+         * @brief Try to add a message of the given size to the pending transmit bytes
+         * @return true if the message fits and was accounted for
+         */
+        bool reserveTransmitSpace(size_t length);
+
+        /**
+         * @brief Reserve space for a message in the transmit buffer according to the overflow policy
+         * With the blocking policy this waits until the work thread wrote enough data or the object is destroyed.
+         * @param length the size of the message
+         * @return true if the message can be queued, false if it was dropped or rejected
+         */
+        bool acquireTransmitSpace(size_t length);
+
+        /**
+         * @brief Account for written or dropped transmit data and wake up waiting Print calls
+         * @param length the number of bytes that are not pending anymore
+         */
+        void releaseTransmitSpace(size_t length);
+
+        /**
+         * @brief Drop the oldest unstarted messages if more than the transmit capacity is pending (dropOldest policy)
+         * This may only be called by the thread that handles the write stage.
+         */
+        void trimTransmitData();
+
+        /**
+         * @brief Connect to the next available device if the current one was lost
+         * This is called by the thread that handles the read stage whenever the current device is not connected.
+         * A new attempt is only made if the hot plug monitor reported a change (or periodically without a monitor).
+         * The attempt runs in the background and its result is picked up by a later call, so this never blocks the I/O path.
+         */
+        void tryReconnect();
+
+        /**
+         * @brief Start opening and probing all devices that are not connected in the background
+         * The caller has to hold the connectMutex.
+         * @return std::shared_ptr<connectAttempt> the attempt, its deadline is set to now plus the connect timeout
+         */
+        std::shared_ptr<connectAttempt> startConnectAttempt();
+
+        /**
+         * @brief Select the current device from the results of an attempt
+         * Devices that are still running are abandoned and closed by their threads once they finish.
+         * The caller has to hold the connectMutex.
+         * @param attempt the attempt that should be evaluated
+         * @return true if a device was connected and accepted
+         */
+        bool finishConnectAttempt(const std::shared_ptr<connectAttempt>& attempt);
+
+        /**
+         * @brief Check if a connection attempt is still opening or probing a device
+         * Such a device might already be connected, but it must not be used until its attempt finished.
+         * @param index the index of the device
+         */
+        [[nodiscard]]
+        bool connectInFlight(size_t index) const noexcept;
+
+        /**
+         * @brief Check if any of the devices is not connected, this is used to keep reconnecting in fan in mode
+         */
+        [[nodiscard]]
+        bool anyDeviceDisconnected() const;
 
       public:
         /**
@@ -69,9 +677,10 @@ namespace sakurajin {
          *
          * @param Rate The  rate that should be used for the connection
          * @param errorStream The stream where error messages should be written to
+         * @param settings Additional settings for the work thread
          */
         [[maybe_unused]]
-        explicit RS232(Baudrate Rate, std::ostream& errorStream = std::cerr);
+        explicit RS232(Baudrate Rate, std::ostream& errorStream = std::cerr, const RS232_settings& settings = {});
 
         /**
          * @brief Construct a new RS232 object with a single device
@@ -80,9 +689,13 @@ namespace sakurajin {
          * @param deviceName The name of the port where the device is connected to
          * @param Rate The  rate that should be used for the connection
          * @param errorStream The stream where error messages should be written to
+         * @param settings Additional settings for the work thread
          */
         [[maybe_unused]]
-        RS232(const std::string& deviceName, Baudrate Rate, std::ostream& errorStream = std::cerr);
+        RS232(const std::string& deviceName,
+              Baudrate              Rate,
+              std::ostream&         errorStream = std::cerr,
+              const RS232_settings& settings    = {});
 
         /**
          * @brief Construct a new RS232 object with a list of devices
@@ -90,9 +703,13 @@ namespace sakurajin {
          * @param deviceNames The list of names of the ports where the device may be connected to
          * @param baudrate The baudrate that should be used for the connection
          * @param errorStream The stream where error messages should be written to
+         * @param settings Additional settings for the work thread
          */
         [[maybe_unused]]
-        RS232(const std::vector<std::string>& deviceNames, Baudrate baudrate, std::ostream& errorStream = std::cerr);
+        RS232(const std::vector<std::string>& deviceNames,
+              Baudrate                        baudrate,
+              std::ostream&                   errorStream = std::cerr,
+              const RS232_settings&           settings    = {});
 
         /**
          * @brief Destroy the RS232.
@@ -103,6 +720,9 @@ namespace sakurajin {
 
         /**
          * @brief connect to the first available device
+         * All devices that are not connected yet are opened (and probed) in parallel. After all attempts finished or the connect
+         * timeout expired, the first device in the list that was connected and accepted by the probe becomes the current device.
+         * If closeUnusedDevices is set in the settings, the other devices that were opened by this call are closed again.
          *
          * @return true if the connection was established successfully
          * @return false if the connection could not be established
@@ -117,6 +737,17 @@ namespace sakurajin {
         [[maybe_unused]]
         void DisconnectAll();
 
+        /**
+         * @brief Change the configuration of the serial line of all devices
+         * The configuration is applied to the open ports, so they are not closed and no received data is lost.
+         * Devices that are not connected only store the configuration and use it once they are connected.
+         * @param config the new configuration
+         * @param errorStream The stream where error messages should be written to
+         * @return true if the current device is connected with the new configuration
+         */
+        [[maybe_unused]]
+        bool changeLineConfiguration(const lineConfiguration& config, std::ostream& errorStream = std::cerr);
+
         /**
          * @brief Get a pointer to a native device
          * If the index is not a valid index the current device will be returned.
@@ -147,18 +778,93 @@ namespace sakurajin {
         [[nodiscard]] [[maybe_unused]]
         size_t getDeviceCount() const;
 
+        /**
+         * @brief Set the maximum number of bytes that are read from the device at once
+         * The work thread reads everything the device has queued up to this size in a single call and then appends the whole chunk to
+         * the read buffer. Larger values reduce the number of system calls and lock operations at high baudrates.
+         * @note the new size is used starting with the next read of the work thread.
+         * @param chunkSize the new maximum chunk size, values smaller than 1 are set to 1
+         */
+        [[maybe_unused]]
+        void setReadChunkSize(size_t chunkSize);
+
+        /**
+         * @brief Get the maximum number of bytes that are read from the device at once
+         * @return size_t the current maximum chunk size
+         */
+        [[nodiscard]] [[maybe_unused]]
+        size_t getReadChunkSize() const;
+
         /**
          * @brief Empty the read buffer and return its content
          * @warning the read buffer will be cleared after this function is called.
+         * @note if the receive ring is used, its whole content is returned instead.
          * @return std::string the content of the read buffer
          */
         [[nodiscard]] [[maybe_unused]]
         std::string retrieveReadBuffer();
 
+        /**
+         * @brief Move received data from the receive ring into a caller provided buffer
+         * This neither locks a mutex nor allocates memory, so it is the fastest way to consume the received data.
+         * @note this only returns data if the object was constructed with a receiveRingCapacity larger than 0.
+         * @warning the ring only supports a single consumer, do not call this from multiple threads at the same time.
+         * @param destination the buffer the data should be copied to
+         * @param length the size of the destination buffer
+         * @return size_t the number of bytes that were copied into destination
+         */
+        [[nodiscard]] [[maybe_unused]]
+        size_t retrieveFromRing(char* destination, size_t length);
+
+        /**
+         * @brief Move received data into a caller provided buffer
+         * The data is taken from the front of the read buffer (or the receive ring if it is used). The read buffer keeps its
+         * capacity, so neither side allocates memory.
+         * @param destination the buffer the data should be copied to
+         * @param length the size of the destination buffer
+         * @return size_t the number of bytes that were copied into destination
+         */
+        [[nodiscard]] [[maybe_unused]]
+        size_t retrieveInto(char* destination, size_t length);
+
+        /**
+         * @brief Exchange the read buffer with a caller provided string
+         * The buffer is cleared and swapped with the read buffer, so afterwards it contains all received data and the work thread
+         * continues with the old capacity of the buffer. If the same buffer is passed every time, the two strings take turns
+         * and the receive path does not allocate anything once both are large enough.
+         * @note if the receive ring is used, its content is copied into the buffer instead.
+         * @param buffer the string that receives the data, its previous content is discarded
+         * @return size_t the number of bytes in buffer
+         */
+        [[maybe_unused]]
+        size_t swapReadBuffer(std::string& buffer);
+
+        /**
+         * @brief Look at the received data without removing it
+         * The view references the received chunks directly, so nothing is copied. Call consume once it is known how much of
+         * the data was handled, the rest stays available for the next call.
+         * @note this only returns data if the object was constructed with receiveRope set to true.
+         * @param maxLength the maximum number of bytes the view should cover
+         * @return RS232_ropeView a view of the oldest received data
+         */
+        [[nodiscard]] [[maybe_unused]]
+        RS232_ropeView peek(size_t maxLength = RS232_ropeView::npos) const;
+
+        /**
+         * @brief Remove data from the front of the receive rope
+         * This only advances an offset and releases the chunks that were consumed completely, the stored data is never moved.
+         * @note this only removes data if the object was constructed with receiveRope set to true.
+         * @param length the number of bytes that should be removed
+         * @return size_t the number of bytes that were removed
+         */
+        [[maybe_unused]]
+        size_t consume(size_t length);
+
         /**
          * @brief load the read buffer and return the first match with a regex
          * This function uses the std::regex_search function to find the first match of the read buffer.
          * If no match is found an empty string is returned.
+         * @note this does not work if the receive ring is used since the data is not stored in the read buffer.
          * @note this function clears the read buffer until the end of the match.
          * If the buffer contains "Hello World!" and the pattern is "World" the buffer will be cleared until the end of the match.
          * The buffer will then contain "!". Everything in front of the match will be discarded.
@@ -183,17 +889,165 @@ namespace sakurajin {
         [[nodiscard]] [[maybe_unused]]
         std::vector<std::string> retrieveAllMatches(const std::regex& pattern);
 
+        /**
+         * @brief load the read buffer and return all matches with a regex, resuming where the last call stopped
+         * This works like retrieveAllMatches but remembers how far the buffer was already searched.
+         * Since no match can be longer than maxMatchLength, bytes that are further away from the end of the buffer than that and did
+         * not match can never become part of a match. The next call skips them and only searches the bytes that could still match.
+         * This makes polling a large backlog with a pattern that rarely matches much cheaper.
+         * @note use the same pattern and maximum length for consecutive calls, otherwise the skipped bytes might have matched.
+         * @note the skipped bytes are not removed from the read buffer, they are only removed by a later match or retrieveReadBuffer.
+         * @param pattern the regex pattern that should be used
+         * @param maxMatchLength the maximum length of a match of the pattern, 0 disables the resuming and searches the whole buffer
+         * @return std::vector<std::string> all matches of the read buffer
+         */
+        [[nodiscard]] [[maybe_unused]]
+        std::vector<std::string> retrieveAllMatches(const std::regex& pattern, size_t maxMatchLength);
+
+        /**
+         * @brief return everything up to and including the first delimiter
+         * This is a much cheaper alternative to retrieveFirstMatch for record based protocols.
+         * The buffer is scanned with memchr or simd instructions instead of a regex.
+         * If no delimiter is in the read buffer an empty string is returned and nothing is removed.
+         * @note this does not work if the receive ring is used since the data is not stored in the read buffer.
+         * @param delimiters every character in this string ends a frame, to use NUL as delimiter pass std::string_view{"\0", 1}
+         * @return std::string the first frame including its delimiter
+         */
+        [[nodiscard]] [[maybe_unused]]
+        std::string retrieveUntil(std::string_view delimiters);
+
+        /**
+         * @brief return all complete frames in the read buffer
+         * A frame ends with any of the delimiters.
+         * All complete frames are extracted with a single lock of the read buffer, the incomplete frame at the end stays in the buffer
+         * until the rest of it is received.
+         * @note this does not work if the receive ring is used since the data is not stored in the read buffer.
+         * @param delimiters every character in this string ends a frame, e.g. "\n" for line based protocols
+         * @param includeDelimiter if true the delimiter is kept at the end of each frame
+         * @return std::vector<std::string> all complete frames in the order they were received
+         */
+        [[nodiscard]] [[maybe_unused]]
+        std::vector<std::string> retrieveFrames(std::string_view delimiters, bool includeDelimiter = true);
+
+        /**
+         * @brief return all frames that were decoded by the frame decoder
+         * The frames are decoded by the work thread as soon as the data arrives, so this only moves the finished frames out.
+         * Incomplete frames are never returned.
+         * @note this only returns frames if a frame decoder was passed in the settings.
+         * @return std::vector<std::string> all decoded frames in the order they were received
+         */
+        [[nodiscard]] [[maybe_unused]]
+        std::vector<std::string> retrieveDecodedFrames();
+
+        /**
+         * @brief Exchange the decoded frames with a caller provided vector
+         * This works like swapReadBuffer, the vector is cleared and swapped so both sides keep their capacity.
+         * @param frames the vector that receives the frames, its previous content is discarded
+         * @return size_t the number of frames in frames
+         */
+        [[maybe_unused]]
+        size_t swapDecodedFrames(std::vector<std::string>& frames);
+
+        /**
+         * @brief return all chunks that were received from the devices in fan in mode
+         * The chunks of all devices are returned as one stream in the order they were read.
+         * @note this only returns chunks if fanIn was set in the settings.
+         * @return std::vector<RS232_chunk> all received chunks, each tagged with its device index and the time it was read
+         */
+        [[nodiscard]] [[maybe_unused]]
+        std::vector<RS232_chunk> retrieveChunks();
+
+        /**
+         * @brief Exchange the received chunks with a caller provided vector
+         * This works like swapReadBuffer, the vector is cleared and swapped so both sides keep their capacity.
+         * @param chunks the vector that receives the chunks, its previous content is discarded
+         * @return size_t the number of chunks in chunks
+         */
+        [[maybe_unused]]
+        size_t swapChunks(std::vector<RS232_chunk>& chunks);
+
+        /**
+         * @brief Write the same data to several devices at the same time
+         * All devices share the same buffer, it is not copied for each device. The thread that handles the write stage waits until
+         * any of the devices can take more data and writes to each of them without blocking, so the data leaves all devices
+         * at about the same time.
+         * If the current device is one of the devices, the message is written between two messages that were passed to Print.
+         * @note the transmit capacity does not limit broadcast messages.
+         * @note if closeUnusedDevices is set, Connect only keeps the current device open, connect the others with
+         * getNativeDevice(i)->connect().
+         * @param data the data that should be written, it must not be changed until all futures are ready
+         * @param deviceIndices the indices of the devices the data should be written to
+         * @return std::vector<std::future<bool>> one future per device in the order of deviceIndices, it becomes true once all data
+         * was written to the device and false if that failed, the device was not connected or the index is not valid
+         */
+        [[nodiscard]] [[maybe_unused]]
+        std::vector<std::future<bool>> Broadcast(std::shared_ptr<const std::string> data, const std::vector<size_t>& deviceIndices);
+
+        /**
+         * @brief Write the same data to all connected devices at the same time
+         * @param data the data that should be written, it must not be changed until all futures are ready
+         * @return std::vector<std::future<bool>> one future per device, the future of a device that is not connected is false
+         */
+        [[nodiscard]] [[maybe_unused]]
+        std::vector<std::future<bool>> Broadcast(std::shared_ptr<const std::string> data);
+
         /**
          * @brief print a string to the currently connected device
-         * This function adds the string to the write buffer and then returns.
-         * The write buffer is then written to the device in the background by the work thread.
+         * This function adds the string to the lock free transmit queue and then returns.
+         * The queued messages are then written to the device in the background by the work thread.
+         * Messages from the same thread are always written in the order they were printed.
          * Because of this the actual write operation might be delayed.
          * For a more immediate write operation use the native device directly.
+         * If a transmit capacity was set in the settings, the transmit overflow policy decides what happens if the message does
+         * not fit.
          *
          * @param text the text to send
+         * @return true if the message was queued, false if it was dropped or rejected because the transmit buffer is full
          */
         [[maybe_unused]]
-        void Print(std::string text);
+        bool Print(std::string text);
+
+        /**
+         * @brief print binary data to the currently connected device
+         * This works like Print(std::string) but copies the data straight into a pooled node of the transmit queue, so once the
+         * pool is warm no memory is allocated. Use the std::string overload to hand over a string that is not needed anymore.
+         * @param text the data to send, it may contain NUL bytes
+         * @return true if the message was queued, false if it was dropped or rejected because the transmit buffer is full
+         */
+        [[maybe_unused]]
+        bool Print(std::string_view text);
+
+        /**
+         * @brief print a NUL terminated string to the currently connected device
+         * This only exists to make calls with string literals unambiguous, see Print(std::string_view).
+         */
+        [[maybe_unused]]
+        bool Print(const char* text);
+
+        /**
+         * @brief print a message that consists of several buffers to the currently connected device
+         * The segments are queued as a single message, so a header, the payload and a checksum can be sent without concatenating
+         * them first. The transmit capacity and the overflow policy are applied to the message as a whole.
+         * @param segments the parts of the message, in order
+         * @param count the number of segments
+         * @return true if the message was queued, false if it was dropped or rejected because the transmit buffer is full
+         */
+        [[maybe_unused]]
+        bool PrintSegments(const std::string_view* segments, size_t count);
+
+        /**
+         * @brief print a message that consists of several buffers to the currently connected device
+         * @param segments the parts of the message, in order
+         * @return true if the message was queued, false if it was dropped or rejected because the transmit buffer is full
+         */
+        [[maybe_unused]]
+        bool PrintSegments(std::initializer_list<std::string_view> segments);
+
+        /**
+         * @brief Get the overflow counters and the fill level of the transmit buffer
+         */
+        [[nodiscard]] [[maybe_unused]]
+        RS232_bufferStats getBufferStats() const;
 
 
         /**
@@ -0,0 +1,181 @@
+#ifndef SAKURAJIN_RS232_CHUNKROPE_HPP_INCLUDED
+#define SAKURAJIN_RS232_CHUNKROPE_HPP_INCLUDED
+
+#ifndef RS232_EXPORT_MACRO
+    #define RS232_EXPORT_MACRO
+#endif
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sakurajin {
+
+    /**
+     * @brief A read only view of the data at the front of a RS232_chunkRope
+     * The view holds a reference to every chunk it covers, so it stays valid even after the data was consumed from the rope or
+     * the rope was destroyed. Nothing is copied when the view is created, only the functions that return a std::string copy data.
+     */
+    class RS232_EXPORT_MACRO RS232_ropeView {
+      private:
+        friend class RS232_chunkRope;
+
+        /// The chunks that are covered by the view, they are kept alive as long as the view exists
+        std::vector<std::shared_ptr<const std::string>> chunks;
+
+        /// The parts of the chunks that belong to the view, in the order they were received
+        std::vector<std::string_view> segments;
+
+        /// The total number of bytes in all segments
+        size_t totalSize = 0;
+
+      public:
+        /// Returned by the find functions if nothing was found
+        static constexpr size_t npos = std::string_view::npos;
+
+        /**
+         * @brief Get the number of bytes in the view
+         */
+        [[nodiscard]]
+        size_t size() const noexcept;
+
+        /**
+         * @brief Check if the view contains no data
+         */
+        [[nodiscard]]
+        bool empty() const noexcept;
+
+        /**
+         * @brief Get the contiguous parts of the view
+         * Each segment points directly into one of the received chunks, so parsers can process the data without copying it.
+         */
+        [[nodiscard]]
+        const std::vector<std::string_view>& getSegments() const noexcept;
+
+        /**
+         * @brief Get a single byte of the view
+         * @param index the position of the byte counted from the front of the view
+         * @throw std::out_of_range if index is not smaller than size()
+         */
+        [[nodiscard]]
+        char at(size_t index) const;
+
+        /**
+         * @brief Find the first occurrence of any of the given characters
+         * @param characters the characters that should be searched for
+         * @param start the position where the search starts
+         * @return size_t the position of the first match or npos if none of the characters was found
+         */
+        [[nodiscard]]
+        size_t findFirstOf(std::string_view characters, size_t start = 0) const noexcept;
+
+        /**
+         * @brief Copy a part of the view into a caller provided buffer
+         * @param destination the buffer the data should be copied to
+         * @param length the maximum number of bytes that should be copied
+         * @param offset the position of the first byte that should be copied
+         * @return size_t the number of bytes that were copied
+         */
+        size_t copyTo(char* destination, size_t length, size_t offset = 0) const noexcept;
+
+        /**
+         * @brief Copy a part of the view into a new string
+         * @param offset the position of the first byte that should be copied
+         * @param length the maximum number of bytes that should be copied, npos copies everything after offset
+         */
+        [[nodiscard]]
+        std::string copy(size_t offset = 0, size_t length = npos) const;
+    };
+
+    /**
+     * @brief A queue of received bytes that is stored as a list of immutable, reference counted chunks.
+     * The RS232 wrapper uses this as an alternative to the read buffer string.
+     * The work thread appends every received chunk as a whole and the user looks at the front of the rope with peek.
+     * Consuming data only advances the offset into the first chunk and releases the chunks that were consumed completely,
+     * so neither side ever moves the stored bytes or reallocates a large buffer.
+     *
+     * All functions are thread safe. Views do not access the rope anymore once they were created, so they can be used without locking.
+     */
+    class RS232_EXPORT_MACRO RS232_chunkRope {
+      private:
+        /// Protects all members
+        mutable std::mutex ropeMutex;
+
+        /// The stored chunks, the oldest one is at the front
+        std::deque<std::shared_ptr<const std::string>> chunks;
+
+        /// The number of bytes of the first chunk that were already consumed
+        size_t frontOffset = 0;
+
+        /// The number of bytes that are stored and not consumed yet
+        size_t totalSize = 0;
+
+        /**
+         * @brief Release consumed data from the front of the rope
+         * The caller has to hold the ropeMutex.
+         * @param length the number of bytes that should be consumed
+         * @return size_t the number of bytes that were consumed, this is less than length if the rope contains less data
+         */
+        size_t consumeLocked(size_t length) noexcept;
+
+      public:
+        RS232_chunkRope() = default;
+
+        RS232_chunkRope(const RS232_chunkRope&)            = delete;
+        RS232_chunkRope& operator=(const RS232_chunkRope&) = delete;
+
+        /**
+         * @brief Get the number of bytes that are currently stored in the rope
+         */
+        [[nodiscard]]
+        size_t size() const;
+
+        /**
+         * @brief Check if the rope contains no data
+         */
+        [[nodiscard]]
+        bool empty() const;
+
+        /**
+         * @brief Copy data into a new chunk and add it to the end of the rope
+         * @param data the data that should be added
+         * @param length the number of bytes in data
+         */
+        void append(const char* data, size_t length);
+
+        /**
+         * @brief Add an existing chunk to the end of the rope without copying it
+         * @param chunk the chunk that should be added, empty chunks and nullptr are ignored
+         */
+        void append(std::shared_ptr<const std::string> chunk);
+
+        /**
+         * @brief Get a view of the data at the front of the rope without removing it
+         * @param maxLength the maximum number of bytes the view should cover
+         */
+        [[nodiscard]]
+        RS232_ropeView peek(size_t maxLength = RS232_ropeView::npos) const;
+
+        /**
+         * @brief Remove data from the front of the rope
+         * @param length the number of bytes that should be removed
+         * @return size_t the number of bytes that were removed, this is less than length if the rope contains less data
+         */
+        size_t consume(size_t length);
+
+        /**
+         * @brief Move data from the front of the rope into a caller provided buffer
+         * @param destination the buffer the data is copied to
+         * @param length the size of the destination buffer
+         * @return size_t the number of bytes that were copied and removed
+         */
+        size_t pop(char* destination, size_t length);
+    };
+
+} // namespace sakurajin
+
+#endif // SAKURAJIN_RS232_CHUNKROPE_HPP_INCLUDED
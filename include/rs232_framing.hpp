@@ -0,0 +1,110 @@
+#ifndef SAKURAJIN_RS232_FRAMING_HPP_INCLUDED
+#define SAKURAJIN_RS232_FRAMING_HPP_INCLUDED
+
+#ifndef RS232_EXPORT_MACRO
+    #define RS232_EXPORT_MACRO
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sakurajin {
+
+    /**
+     * @brief The interface of all binary frame decoders
+     * A decoder turns the raw byte stream of a device into complete, decoded frames.
+     * If a decoder is passed in the RS232_settings, the work thread feeds every received chunk into it and only the decoded frames are
+     * passed to the user.
+     * The data can be split at any position between two calls to decode, so each decoder keeps the state of the current frame.
+     *
+     * Implement this interface to add support for other framing protocols.
+     */
+    class RS232_EXPORT_MACRO RS232_frameDecoder {
+      public:
+        virtual ~RS232_frameDecoder() = default;
+
+        /**
+         * @brief Decode the next chunk of the byte stream
+         * @param data the received data
+         * @param length the number of bytes in data
+         * @param frames every frame that is completed by this chunk is appended to this list
+         */
+        virtual void decode(const char* data, size_t length, std::vector<std::string>& frames) = 0;
+
+        /**
+         * @brief Discard the partially received frame
+         */
+        virtual void reset() noexcept = 0;
+    };
+
+    /**
+     * @brief A decoder for consistent overhead byte stuffing (COBS) with 0x00 as frame delimiter
+     * Frames that are not valid COBS or longer than the maximum length are dropped.
+     */
+    class RS232_EXPORT_MACRO RS232_cobsDecoder : public RS232_frameDecoder {
+      private:
+        std::string currentFrame;
+        size_t      maxFrameLength;
+        uint8_t     remainingBlock = 0;
+        bool        pendingZero    = false;
+        bool        invalidFrame   = false;
+
+      public:
+        /**
+         * @param maxFrameLength the maximum length of a decoded frame, longer frames are dropped
+         */
+        explicit RS232_cobsDecoder(size_t maxFrameLength = 4096);
+
+        void decode(const char* data, size_t length, std::vector<std::string>& frames) override;
+        void reset() noexcept override;
+    };
+
+    /**
+     * @brief A decoder for the serial line internet protocol (SLIP, RFC 1055)
+     * Frames are delimited by 0xC0, 0xDB is used as escape character.
+     * Empty frames are ignored, frames longer than the maximum length are dropped.
+     */
+    class RS232_EXPORT_MACRO RS232_slipDecoder : public RS232_frameDecoder {
+      private:
+        std::string currentFrame;
+        size_t      maxFrameLength;
+        bool        escaped      = false;
+        bool        invalidFrame = false;
+
+      public:
+        /**
+         * @param maxFrameLength the maximum length of a decoded frame, longer frames are dropped
+         */
+        explicit RS232_slipDecoder(size_t maxFrameLength = 4096);
+
+        void decode(const char* data, size_t length, std::vector<std::string>& frames) override;
+        void reset() noexcept override;
+    };
+
+    /**
+     * @brief A decoder for frames that start with their length as 16 bit unsigned integer
+     * The length only counts the payload, not the two header bytes.
+     * The returned frames only contain the payload.
+     */
+    class RS232_EXPORT_MACRO RS232_lengthPrefixDecoder : public RS232_frameDecoder {
+      private:
+        std::string currentFrame;
+        bool        bigEndian;
+        uint8_t     headerBytes   = 0;
+        uint16_t    payloadLength = 0;
+
+      public:
+        /**
+         * @param isBigEndian true if the length is sent with the most significant byte first
+         */
+        explicit RS232_lengthPrefixDecoder(bool isBigEndian = true);
+
+        void decode(const char* data, size_t length, std::vector<std::string>& frames) override;
+        void reset() noexcept override;
+    };
+
+} // namespace sakurajin
+
+#endif // SAKURAJIN_RS232_FRAMING_HPP_INCLUDED
@@ -0,0 +1,97 @@
+#ifndef SAKURAJIN_RS232_HOTPLUG_HPP_INCLUDED
+#define SAKURAJIN_RS232_HOTPLUG_HPP_INCLUDED
+
+#include "rs232_native.hpp"
+
+#include <future>
+
+namespace sakurajin {
+
+    /**
+     * @brief Watches for serial devices that are added or removed.
+     * On linux a single background thread blocks on an inotify handle for /dev and /dev/serial/by-id (and by-path).
+     * Whenever a device node is created, removed or its permissions change, all subscribers are flagged and their wakeup handle is
+     * notified. The subscribers then decide themselves if they have to reconnect, so no thread ever polls for devices.
+     *
+     * All RS232 objects share the same monitor. It is created by the first object that requests it and destroyed with the last one.
+     * Other platforms are not supported yet, there the RS232 objects check their devices periodically instead.
+     */
+    class RS232_EXPORT_MACRO RS232_hotplugMonitor {
+      private:
+        /**
+         * @brief An object that wants to be informed about device changes
+         */
+        struct subscriber {
+            /// Set to true on every change, the subscriber resets it once it handled the change
+            std::atomic<bool>* changed = nullptr;
+            /// Notified on every change to wake up the thread of the subscriber
+            RS232_wakeup* wakeup = nullptr;
+        };
+
+        /// The mutex that protects the list of subscribers, it is held while they are notified
+        std::mutex subscriberMutex;
+
+        /// All objects that are informed about device changes
+        std::vector<subscriber> subscribers;
+
+        /**
+         * @brief The platform specific handles of the monitor
+         *
+         * This is a void pointer to prevent the need of including the platform specific header files.
+         * On linux this points to an array with the inotify file descriptor and an eventfd that stops the thread.
+         */
+        void* monitorHandle = nullptr;
+
+        /// The thread that waits for device changes
+        std::future<void> thread;
+
+        /**
+         * @brief The loop that is executed by the monitor thread
+         */
+        void run();
+
+        /**
+         * @brief Set the changed flag of all subscribers and notify their wakeup handles
+         */
+        void notifySubscribers();
+
+      public:
+        /**
+         * @brief Construct a new monitor and start its thread
+         * @throw std::runtime_error if device changes cannot be monitored on this platform
+         */
+        RS232_hotplugMonitor();
+
+        /**
+         * @brief Stop the monitor thread
+         */
+        ~RS232_hotplugMonitor();
+
+        RS232_hotplugMonitor(const RS232_hotplugMonitor&)            = delete;
+        RS232_hotplugMonitor& operator=(const RS232_hotplugMonitor&) = delete;
+
+        /**
+         * @brief Get the monitor that is shared by all objects of this process
+         * @return std::shared_ptr<RS232_hotplugMonitor> the shared monitor or nullptr if monitoring is not supported
+         */
+        [[nodiscard]]
+        static std::shared_ptr<RS232_hotplugMonitor> getShared() noexcept;
+
+        /**
+         * @brief Get informed about every device change
+         * @param changed the flag that is set to true on every change
+         * @param wakeup the wakeup handle that is notified on every change, nullptr if only the flag should be set
+         */
+        void subscribe(std::atomic<bool>* changed, RS232_wakeup* wakeup);
+
+        /**
+         * @brief Stop getting informed about device changes
+         * When this returns the flag and the wakeup handle are not accessed by the monitor anymore.
+         * @param changed the flag that was passed to subscribe
+         */
+        void unsubscribe(std::atomic<bool>* changed);
+    };
+
+} // namespace sakurajin
+
+#endif // SAKURAJIN_RS232_HOTPLUG_HPP_INCLUDED
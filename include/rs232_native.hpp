@@ -14,6 +14,7 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <climits>
 #include <filesystem>
 #include <functional>
 #include <iostream>
@@ -72,6 +73,159 @@ namespace sakurajin {
 #endif
     };
 
+    /**
+     * @brief An enum to define the io events that can be waited for
+     * The values are bit flags and can be combined to wait for multiple events at once.
+     */
+    enum ioEvent {
+        /// No event occurred (the wait timed out or was interrupted by a wakeup)
+        ioNone = 0,
+        /// There is data that can be read from the device
+        ioReadable = 1,
+        /// Data can be written to the device without blocking
+        ioWritable = 2,
+        /// The device reported an error or was removed
+        ioError = 4
+    };
+
+    class RS232_native;
+    struct ioWaitEntry;
+
+    /**
+     * @brief A platform specific notification handle that can interrupt waitForEvents.
+     * On linux this is an eventfd, on other unix systems a pipe and on windows an event object.
+     * Any thread may call notify() to wake up a thread that is waiting for io events.
+     * The notification stays pending until it is consumed by the next wait.
+     */
+    class RS232_EXPORT_MACRO RS232_wakeup {
+      private:
+        /**
+         * @brief The platform specific handle of the notification object
+         *
+         * This is a void pointer to prevent the need of including the platform specific header files.
+         * On windows this points to a HANDLE and on unix to an array of two ints.
+         */
+        void* wakeupHandle = nullptr;
+
+      public:
+        RS232_wakeup();
+        ~RS232_wakeup();
+
+        RS232_wakeup(const RS232_wakeup&)            = delete;
+        RS232_wakeup& operator=(const RS232_wakeup&) = delete;
+
+        /**
+         * @brief Signal the notification and wake up the waiting thread
+         */
+        void notify() noexcept;
+
+        /**
+         * @brief Reset the notification so that the next wait blocks again
+         */
+        void clear() noexcept;
+
+        friend RS232_EXPORT_MACRO int
+        waitForEvents(ioWaitEntry* entries, size_t entryCount, RS232_wakeup* wakeup, std::chrono::milliseconds timeout) noexcept;
+    };
+
+    /**
+     * @brief A single device that should be watched by waitForEvents
+     */
+    struct ioWaitEntry {
+        /// The device that should be watched
+        RS232_native* device = nullptr;
+        /// The events (a combination of ioEvent) that should be waited for
+        int requested = ioNone;
+        /// The events that occurred on the device, this is set by waitForEvents
+        int returned = ioNone;
+    };
+
+    /**
+     * @brief Block until one of the devices has one of the requested events, the wakeup is notified or the timeout expires.
+     * This replaces busy waiting on non blocking reads, while waiting the calling thread does not use any cpu time.
+     * On unix this uses poll on the port file descriptors and the wakeup handle.
+     * On windows serial ports cannot be waited on without overlapped io, so the queue sizes are checked and the wakeup event is
+     * waited on in 1ms steps instead.
+     * @note devices that are not connected are ignored and get ioNone as returned events.
+     * @note a pending notification of the wakeup is consumed by this function.
+     *
+     * @param entries the devices that should be watched, the returned field of every entry is set by this function
+     * @param entryCount the number of elements in entries
+     * @param wakeup the wakeup handle that can interrupt the wait, may be nullptr
+     * @param timeout the maximum duration of the wait, a negative value waits forever
+     * @return int the number of devices with events, 0 on timeout or wakeup and negative if an error occurred
+     */
+    RS232_EXPORT_MACRO int
+    waitForEvents(ioWaitEntry* entries, size_t entryCount, RS232_wakeup* wakeup, std::chrono::milliseconds timeout) noexcept;
+
+    /**
+     * @brief The latency related settings that are actually used by the driver of a device
+     */
+    struct latencyInfo {
+        /// true if the tty layer passes received data to the reader immediately (ASYNC_LOW_LATENCY on linux)
+        bool lowLatency = false;
+        /// The latency timer of an usb serial adapter in milliseconds, -1 if the adapter does not have one or it cannot be read
+        int latencyTimer = -1;
+    };
+
+    /**
+     * @brief An enum to define the parity bit of each character
+     */
+    enum parityMode {
+        /// No parity bit is sent
+        noParity,
+        /// The parity bit makes the number of set bits odd
+        oddParity,
+        /// The parity bit makes the number of set bits even
+        evenParity,
+        /// The parity bit is always set
+        markParity,
+        /// The parity bit is never set
+        spaceParity
+    };
+
+    /**
+     * @brief An enum to define the number of stop bits after each character
+     */
+    enum stopBits {
+        /// A single stop bit, the most common setting
+        oneStopBit,
+        /// Two stop bits, gives slow receivers more time between characters
+        twoStopBits
+    };
+
+    /**
+     * @brief The configuration of the serial line
+     * The default values are the 8N1 configuration without flow control that was always used before.
+     * Flow control is needed to transfer data at a high rate into a slow device without losing data.
+     */
+    struct lineConfiguration {
+        /// The number of data bits of each character, 5 to 8
+        uint8_t dataBits = 8;
+        /// The parity bit of each character
+        parityMode parity = noParity;
+        /// The number of stop bits after each character
+        stopBits stopBitCount = oneStopBit;
+        /// Use the RTS and CTS lines for hardware flow control
+        bool hardwareFlowControl = false;
+        /// Use XON and XOFF characters for software flow control in both directions
+        bool softwareFlowControl = false;
+        /// The character that tells the other side to continue sending
+        char xonChar = 0x11;
+        /// The character that tells the other side to stop sending
+        char xoffChar = 0x13;
+        /**
+         * @brief XON is sent once the input buffer contains at most this many bytes
+         * @note this is only used on windows, on linux the tty layer uses fixed thresholds
+         */
+        uint16_t xonLimit = 2048;
+        /**
+         * @brief XOFF is sent once the free space in the input buffer is at most this many bytes
+         * @note this is only used on windows, on linux the tty layer uses fixed thresholds
+         */
+        uint16_t xoffLimit = 512;
+    };
+
     RS232_EXPORT_MACRO std::vector<std::string> getAvailablePorts() noexcept;
     RS232_EXPORT_MACRO std::vector<std::string> getMatchingPorts(const std::regex& pattern) noexcept;
 
@@ -123,49 +277,230 @@ namespace sakurajin {
         std::atomic<Baudrate> baudrate = Baudrate::baud9600;
 
         /**
-         * @brief The mutex that is used to prevent multiple threads from accessing the port at the same time
-         *
+         * @brief The bit rate that was requested as plain number.
+         * If this is 0 the baudrate enum is used, otherwise this overrides it.
+         * This allows rates that have no constant in the Baudrate enum (for example 250000 or 12000000 bits/s).
+         */
+        std::atomic<uint32_t> customBaudrate = 0;
+
+        /**
+         * @brief The bit rate that is actually used by the driver.
+         * This is read back from the port after the configuration was applied and 0 if it is not known.
+         */
+        std::atomic<uint32_t> appliedBaudrate = 0;
+
+        /**
+         * @brief If true the low latency settings are applied every time the port is connected
+         */
+        std::atomic<bool> lowLatency = false;
+
+        /**
+         * @brief The latency timer in milliseconds that should be used in low latency mode
+         */
+        std::atomic<uint8_t> lowLatencyTimer = 1;
+
+        /**
+         * @brief The latency timer of the adapter before low latency mode was enabled, -1 if it was not changed
+         * This is used to restore the timer once low latency mode is disabled again.
+         */
+        int originalLatencyTimer = -1;
+
+        /**
+         * @brief The low latency flag of the port before low latency mode was enabled, -1 if it was not changed
+         * The flag and the latency timer belong to the adapter and outlive the file descriptor, so disconnect restores both.
+         */
+        int originalLowLatencyFlag = -1;
+
+        /**
+         * @brief The configuration of the serial line
+         * This is protected by the dataAccessMutex, since it is too large to be atomic.
+         */
+        lineConfiguration lineConfig;
+
+        /**
+         * @brief The mutex that protects the connection state
+         * Every io operation holds a shared lock on this mutex, so reads and writes can run at the same time.
+         * Connecting and disconnecting lock it exclusively, so the port is never changed while it is accessed.
          */
         std::shared_mutex dataAccessMutex;
 
-        template <typename retVal>
-        using encapsulatedFunction = std::function<retVal()>;
+        /**
+         * @brief The mutexes that prevent multiple threads from reading or writing at the same time
+         * The read and write path of the port are independent, so a reader never has to wait for a writer and vice versa.
+         */
+        std::mutex readMutex;
+        std::mutex writeMutex;
 
         /**
-         * @brief A method to make a function call with a lock on the mutex
+         * @brief A method to make a function call with a lock on the mutexes
          * This method is used to prevent code duplication.
-         * In case the block parameter is true, the mutex will be locked before the function call and unlocked afterwards.
-         * If the block parameter is false, the mutex will be tried to lock and if that is not immediately possible -1 will be returned.
-         * In that case the passed function will not be called.
+         * The connection mutex is locked shared and the given direction mutex (if any) exclusively.
+         * In case the block parameter is true, the mutexes will be locked before the function call and unlocked afterwards.
+         * If the block parameter is false, the mutexes will be tried to lock and if that is not immediately possible -1 will be
+         * returned. In that case the passed function will not be called.
+         * The function is passed as template parameter, so the call can be inlined and nothing has to be allocated.
          *
-         * @tparam args The types of the arguments that should be passed to the function
-         * @param lock A boolean that indicates if the mutex should be waited for or not
+         * @tparam Func The type of the function that should be called
+         * @param directionMutex The mutex of the read or write path, nullptr if the function does not need one
          * @param func The function that should be called
-         * @return ssize_t The return value of the function or -1 if something went wrong
+         * @param block A boolean that indicates if the mutexes should be waited for or not
+         * @return int64_t The return value of the function or -1 if something went wrong
          */
-        template <typename retT>
-        int64_t callWithOptionalLock(const encapsulatedFunction<retT>& func, bool block = true) {
-            // lock the mutex if the lock parameter is true
-            // otherwise exit if the lock cannot be acquired
+        template <typename Func>
+        int64_t callWithOptionalLock(std::mutex* directionMutex, Func&& func, bool block = true) {
+            std::shared_lock connectionLock{dataAccessMutex, std::defer_lock};
+            std::unique_lock<std::mutex> directionLock;
+            if (directionMutex != nullptr) {
+                directionLock = std::unique_lock{*directionMutex, std::defer_lock};
+            }
+
+            // lock the mutexes if the lock parameter is true
+            // otherwise exit if the locks cannot be acquired
             if (block) {
-                dataAccessMutex.lock();
-            } else if (!dataAccessMutex.try_lock()) {
+                connectionLock.lock();
+                if (directionLock.mutex() != nullptr) {
+                    directionLock.lock();
+                }
+            } else if (!connectionLock.try_lock() || (directionLock.mutex() != nullptr && !directionLock.try_lock())) {
                 return -1;
             }
 
-            // call the function and unlock the mutex before passing the return value.
-            auto retVal = func();
-            dataAccessMutex.unlock();
-            return static_cast<int64_t>(retVal);
+            // the port might have been closed while waiting for the lock
+            if (portHandle == nullptr) {
+                return -1;
+            }
+
+            return static_cast<int64_t>(func());
+        }
+
+        /**
+         * @brief The platform specific function to apply the bit rate and line configuration to the open port
+         * The settings are changed on the open port, so no data in the input queue is lost.
+         * The settings are used immediately, reconfigure calls drainOutput first so the pending output is sent with the old ones.
+         * The caller has to hold an exclusive lock on the dataAccessMutex.
+         * @param error_stream the stream where the error messages should be written to
+         * @return true the settings were applied
+         */
+        bool applyPortSettings(std::ostream& error_stream) noexcept;
+
+        /**
+         * @brief The platform specific function to open the port with the current settings
+         * The caller has to hold an exclusive lock on the dataAccessMutex and the port has to be closed.
+         * @param error_stream the stream where the error messages should be written to
+         * @param settingsRejected set to true if the port was opened but the settings could not be applied to it
+         * @return connectionStatus the new connection status
+         */
+        connectionStatus openPort(std::ostream& error_stream, bool& settingsRejected) noexcept;
+
+        /**
+         * @brief The platform specific function to get the number of bytes in the output queue of the driver
+         * @return int64_t the number of bytes that were written but not sent yet or -1 if the port is closed or the query failed
+         */
+        int64_t pendingOutput() noexcept;
+
+        /**
+         * @brief Wait until the output queue of the driver is empty
+         * Only the shared lock is held while waiting, so reads and writes continue.
+         * The wait ends early if the queue stops shrinking (for example because the peer holds CTS low) or takes too long,
+         * so a reconfiguration never blocks the port forever.
+         */
+        void drainOutput() noexcept;
+
+        /**
+         * @brief Change the port settings without closing the port
+         * The change function modifies the settings members while the connection mutex is locked exclusively.
+         * If the port is open the new settings are applied to it directly, otherwise the port is connected with them unless
+         * connectIfClosed is false. If the port rejects the new settings, the previous settings are restored.
+         * A port that cannot be opened for another reason (for example because the device is missing) keeps the new settings.
+         *
+         * @tparam Func The type of the function that changes the settings
+         * @param change The function that changes the settings
+         * @param error_stream the stream where the error messages should be written to
+         * @param connectIfClosed false if a closed port should only store the new settings for the next connect
+         * @return true the new settings are used by a connected port
+         */
+        template <typename Func>
+        bool reconfigure(Func&& change, std::ostream& error_stream, bool connectIfClosed = true) noexcept {
+            // the output that was already written is sent with the old settings before the exclusive lock is taken
+            drainOutput();
+
+            std::unique_lock lock{dataAccessMutex};
+
+            Baudrate          previousBaudrate       = baudrate;
+            uint32_t          previousCustomBaudrate = customBaudrate;
+            lineConfiguration previousLineConfig     = lineConfig;
+            change();
+
+            if (portHandle == nullptr) {
+                if (!connectIfClosed) {
+                    return false;
+                }
+
+                bool settingsRejected = false;
+                if (openPort(error_stream, settingsRejected) == connectionStatus::connected) {
+                    return true;
+                }
+
+                // otherwise settings that the port rejected would make every later connect fail as well
+                if (settingsRejected) {
+                    baudrate       = previousBaudrate;
+                    customBaudrate = previousCustomBaudrate;
+                    lineConfig     = previousLineConfig;
+                }
+                return false;
+            }
+
+            if (applyPortSettings(error_stream)) {
+                return true;
+            }
+
+            baudrate       = previousBaudrate;
+            customBaudrate = previousCustomBaudrate;
+            lineConfig     = previousLineConfig;
+            applyPortSettings(error_stream);
+            return false;
         }
 
+        /**
+         * @brief The platform specific function to apply the low latency settings to the open port
+         * The caller has to hold an exclusive lock on the dataAccessMutex.
+         * @param error_stream the stream where the error messages should be written to
+         * @return true all settings were applied
+         */
+        bool applyLatencySettings(std::ostream& error_stream) noexcept;
+
+        friend RS232_EXPORT_MACRO int
+        waitForEvents(ioWaitEntry* entries, size_t entryCount, RS232_wakeup* wakeup, std::chrono::milliseconds timeout) noexcept;
+
       public:
         /**
          * @brief Construct a new RS232 object
          *
          * @param deviceName The name of the port where the device is connected to
+         * @param config The configuration of the serial line
+         * @param openPort open the port right away, if this is false connect has to be called before the port can be used
+         */
+        RS232_native(std::string              deviceName,
+                     Baudrate                 Rate,
+                     std::ostream&            error_stream = std::cerr,
+                     const lineConfiguration& config       = {},
+                     bool                     openPort     = true);
+
+        /**
+         * @brief Construct a new RS232 object with an arbitrary bit rate
+         * On linux the rate is applied with termios2 and BOTHER, on windows it is written to the DCB and on other unix systems it
+         * is passed to cfsetspeed. The driver may round the rate, use getBaudrate to get the rate that is actually used.
+         *
+         * @param deviceName The name of the port where the device is connected to
+         * @param bitsPerSecond The bit rate that should be used
+         * @param config The configuration of the serial line
+         * @param openPort open the port right away, if this is false connect has to be called before the port can be used
          */
-        RS232_native(std::string deviceName, Baudrate Rate, std::ostream& error_stream = std::cerr);
+        RS232_native(std::string              deviceName,
+                     uint32_t                 bitsPerSecond,
+                     std::ostream&            error_stream = std::cerr,
+                     const lineConfiguration& config       = {},
+                     bool                     openPort     = true);
 
         /**
          * @brief Destroy the RS232 object
@@ -186,13 +521,73 @@ namespace sakurajin {
 
         /**
          * @brief Change the baudrate of the connection
-         * This function disconnects the port and reconnects it with the new baudrate.
+         * The new baudrate is applied to the open port, so it is not closed and no received data is lost.
+         * Data that was already written is still sent with the old baudrate.
          * @param Rate the new baudrate
          * @param error_stream the stream where the error messages should be written to
-         * @return true the baudrate was changed and a connection was established
+         * @return true the baudrate was changed and the port is connected, on failure the previous baudrate is kept
          */
         bool changeBaudrate(Baudrate Rate, std::ostream& error_stream = std::cerr) noexcept;
 
+        /**
+         * @brief Change the bit rate of the connection to an arbitrary value
+         * The new bit rate is applied to the open port, just like with the other changeBaudrate overload.
+         * @param bitsPerSecond the new bit rate
+         * @param error_stream the stream where the error messages should be written to
+         * @return true the bit rate was changed and a connection was established
+         */
+        bool changeBaudrate(uint32_t bitsPerSecond, std::ostream& error_stream = std::cerr) noexcept;
+
+        /**
+         * @brief Get the bit rate that is actually used by the driver
+         * Drivers may round a requested rate to the closest one they support, this returns the rounded value.
+         * @return uint32_t the bit rate in bits per second or 0 if it is not known or the port is not connected
+         */
+        [[nodiscard]]
+        uint32_t getBaudrate() const noexcept;
+
+        /**
+         * @brief Change the configuration of the serial line
+         * The new configuration is applied to the open port, just like changeBaudrate does with the baudrate.
+         * @param config the new configuration
+         * @param error_stream the stream where the error messages should be written to
+         * @param connectIfClosed false if a closed port should not be connected, it only stores the configuration for the next connect
+         * @return true the configuration is valid, it was applied and a connection was established
+         */
+        bool changeLineConfiguration(const lineConfiguration& config,
+                                     std::ostream&            error_stream    = std::cerr,
+                                     bool                     connectIfClosed = true) noexcept;
+
+        /**
+         * @brief Get the configuration of the serial line
+         * @note This operation can take some time since the mutex has to be locked.
+         */
+        [[nodiscard]]
+        lineConfiguration getLineConfiguration() noexcept;
+
+        /**
+         * @brief Enable or disable the low latency mode of the port
+         * By default the tty layer defers passing received data to the reader and usb serial adapters collect data until their
+         * latency timer expires (16ms by default on FTDI adapters).
+         * In low latency mode ASYNC_LOW_LATENCY is set with TIOCSSERIAL and the latency_timer in sysfs is set to the given value
+         * if the adapter has one. Writing the latency timer usually needs write permission for the sysfs file.
+         * Disabling the mode restores the previous latency timer.
+         * The setting is remembered and applied again on every reconnect.
+         * @note this is only supported on linux, use getLatencyInfo to check which settings are actually used.
+         * @param enable true if the low latency mode should be used
+         * @param latencyTimer the latency timer of the adapter in milliseconds
+         * @param error_stream the stream where the error messages should be written to
+         * @return true all settings were applied (or the port is not connected and they will be applied on connect)
+         */
+        bool setLowLatency(bool enable, uint8_t latencyTimer = 1, std::ostream& error_stream = std::cerr) noexcept;
+
+        /**
+         * @brief Read the latency settings that are actually used by the driver
+         * @return latencyInfo the effective settings, the default values if the port is not connected or they cannot be read
+         */
+        [[nodiscard]]
+        latencyInfo getLatencyInfo() noexcept;
+
         /**
          * @brief disconnects the port and prevents further access
          * This function will always close the connection and will not throw an exception
@@ -210,6 +605,18 @@ namespace sakurajin {
         [[nodiscard]]
         int64_t readRawData(char* data_location, int length, bool block = true) noexcept;
 
+        /**
+         * @brief Wait until data is available and read it
+         * Instead of retrying a non blocking read the calling thread sleeps in waitForEvents until the device has data or the
+         * timeout expires. Everything that is available is returned, up to the given length.
+         * @param data_location the buffer the data should be written to
+         * @param length the maximum number of bytes that should be read
+         * @param timeout the maximum time to wait for data, a negative value waits forever
+         * @return int64_t the number of bytes that were read, 0 if the timeout expired and negative if an error occurred
+         */
+        [[nodiscard]]
+        int64_t readRawDataTimed(char* data_location, int length, std::chrono::milliseconds timeout) noexcept;
+
         /**
          * @brief The platform specific function to write a string to the port
          * @param data the data that should be written to the port
@@ -218,7 +625,19 @@ namespace sakurajin {
          * @return int the number of bytes that were written to the port
          */
         [[nodiscard]]
-        int64_t writeRawData(char* data_location, int length, bool block = true) noexcept;
+        int64_t writeRawData(const char* data_location, int length, bool block = true) noexcept;
+
+        /**
+         * @brief The platform specific function to write several buffers to the port with a single call
+         * On unix this uses writev, so for example a header, the payload and a checksum can be written without concatenating them.
+         * On windows the segments are written one after the other while holding the lock.
+         * @param segments the buffers that should be written, in order
+         * @param count the number of segments
+         * @param block set to true if you want this code to block. If set to false this returns early if the mutex cannot be locked
+         * @return int64_t the total number of bytes that were written to the port, this may end in the middle of a segment
+         */
+        [[nodiscard]]
+        int64_t writeSegments(const std::string_view* segments, size_t count, bool block = true) noexcept;
 
         /**
          * @brief Checks if the connection was started successfully
@@ -286,31 +705,58 @@ namespace sakurajin {
                 return {'\0', -2};
             }
 
-            auto startTime = std::chrono::high_resolution_clock::now();
+            // sleep in the kernel until the next character arrives instead of spinning on non blocking reads
+            char IOBuf   = '\0';
+            auto timeout = ignoreTime ? std::chrono::milliseconds(-1) : std::chrono::ceil<std::chrono::milliseconds>(waitTime);
+            if (transferDevice->readRawDataTimed(&IOBuf, 1, timeout) < 1) {
+                return {'\0', -3};
+            }
 
-            char    IOBuf = '\0';
-            int64_t readLength;
+            return {IOBuf, 0};
+        }
 
-            do {
-                readLength = transferDevice->readRawData(&IOBuf, 1, false);
+        /**
+         * @brief wait for data and read everything that is available
+         * This is meant for request/response protocols, the thread sleeps until the answer arrives or the waitTime is over.
+         *
+         * @param maxLength the maximum number of bytes that should be returned
+         * @param waitTime the duration that should be waited for data before stopping the function.
+         * @param ignoreTime true if the duration value should be ignored (wait until data arrives)
+         *
+         * @return std::tuple<std::string, int> this tuple contains the received data and an error code in case something went wrong
+         * The return value is >= 0 if everything is okay and < 0 if something went wrong
+         */
+        template <class Rep = int64_t, class Period = std::ratio<1>>
+        [[nodiscard]] [[maybe_unused]]
+        std::tuple<std::string, int> ReadAvailable(const std::shared_ptr<RS232_native>& transferDevice,
+                                                   size_t                               maxLength,
+                                                   std::chrono::duration<Rep, Period>   waitTime,
+                                                   bool                                 ignoreTime = false) {
+            if (transferDevice == nullptr) {
+                return {"", -1};
+            }
 
-                if (ignoreTime) {
-                    std::this_thread::sleep_for(std::chrono::nanoseconds(1));
-                    continue;
-                }
+            if (transferDevice->getConnectionStatus() != sakurajin::connectionStatus::connected) {
+                return {"", -2};
+            }
 
-                if (std::chrono::high_resolution_clock::now() - startTime > waitTime) {
-                    return {'\0', -3};
-                }
-            } while (readLength < 1);
+            std::string data(std::min<size_t>(maxLength, INT_MAX), '\0');
+            auto        timeout    = ignoreTime ? std::chrono::milliseconds(-1) : std::chrono::ceil<std::chrono::milliseconds>(waitTime);
+            auto        readLength = transferDevice->readRawDataTimed(data.data(), static_cast<int>(data.size()), timeout);
+            if (readLength < 1) {
+                return {"", -3};
+            }
 
-            return {IOBuf, 0};
+            data.resize(static_cast<size_t>(readLength));
+            return {data, 0};
         }
 
         /**
          * @brief read the interface until one of the stop conditions is reached or the waitTaime is over
          * The waitTime is the time the code will wait for each next character. If the delay between the
          * characters is too long the function will return an error.
+         * @note the data is read one character at a time, since the native device cannot put back data that was read past the stop
+         * condition. The waiting for each character is done in the kernel, so no cpu time is spent while waiting.
          *
          * @param waitTime the duration that should be waited for a signal before stopping the function.
          * @param ignoreTime true if the duration value should be ignored (the same as no parameter)
@@ -379,13 +825,28 @@ namespace sakurajin {
         /**
          * @brief Directly output a string to the device.
          * The string is written to the device and the function returns immediately after that.
+         * The data is written in as few calls as possible, partial writes are resumed once the device can take more data.
          * @note this function is blocking and will wait until a write can actually be performed.
          * @param transferDevice The device that should be used for the transfer
          * @param text The text that should be written to the device
          * @return negative if an error occurred
          */
         [[maybe_unused]]
-        RS232_EXPORT_MACRO int Print(const std::shared_ptr<RS232_native>& transferDevice, const std::string& text);
+        RS232_EXPORT_MACRO int Print(const std::shared_ptr<RS232_native>& transferDevice, std::string_view text);
+
+        /**
+         * @brief Directly output several buffers to the device as one message
+         * The segments are passed to the device with writeSegments, so they are not concatenated first.
+         * Partial writes are resumed once the device can take more data, just like with Print.
+         * @note this function is blocking and will wait until all segments were written.
+         * @param transferDevice The device that should be used for the transfer
+         * @param segments the buffers that should be written, in order
+         * @param count the number of segments
+         * @return negative if an error occurred
+         */
+        [[maybe_unused]]
+        RS232_EXPORT_MACRO int
+        PrintSegments(const std::shared_ptr<RS232_native>& transferDevice, const std::string_view* segments, size_t count);
 
         /**
          * @brief reads until the next character is received
@@ -0,0 +1,182 @@
+#ifndef SAKURAJIN_RS232_PORTINDEX_HPP_INCLUDED
+#define SAKURAJIN_RS232_PORTINDEX_HPP_INCLUDED
+
+#include "rs232_hotplug.hpp"
+
+namespace sakurajin {
+
+    /**
+     * @brief Everything that is known about an available serial port
+     * Except for the device path all fields are only filled on linux, where they are read from /sys/class/tty.
+     * Fields that are not known are left empty (or 0).
+     */
+    struct portInfo {
+        /// The path of the device node, this can be passed to RS232_native (for example /dev/ttyUSB0 or \\.\COM3)
+        std::string devicePath;
+        /// The kernel driver of the port (for example ftdi_sio, cp210x or cdc_acm)
+        std::string driver;
+        /// The USB vendor id of the adapter
+        uint16_t vendorId = 0;
+        /// The USB product id of the adapter
+        uint16_t productId = 0;
+        /// The serial number of the USB adapter
+        std::string serialNumber;
+        /// The manufacturer string of the USB adapter
+        std::string manufacturer;
+        /// The product string of the USB adapter
+        std::string product;
+        /// The persistent link in /dev/serial/by-id that points to this port
+        std::string byIdPath;
+    };
+
+    /**
+     * @brief A cached index of the available serial ports and their metadata
+     * The ports are found with a single pass over /dev (or the dos device names on windows).
+     * Only ports that were not in the index before are looked up in sysfs, the entries of known ports are kept.
+     * If the RS232_hotplugMonitor is available, the devices are only scanned again after it reported a change, so repeated queries
+     * are answered from the cache without touching the file system.
+     *
+     * All functions refresh the index before they answer and are thread safe.
+     */
+    class RS232_EXPORT_MACRO RS232_portIndex {
+      private:
+        /**
+         * @brief A port in the index
+         */
+        struct indexEntry {
+            /// The information about the port
+            portInfo info;
+            /// Identifies the device node (the inode on unix), a device that is replaced under the same name gets a new id
+            uint64_t nodeId = 0;
+            /// The position of the name pattern that matched, usb serial adapters (ttyUSB) are listed before modems (ttyACM)
+            uint32_t rank = 0;
+        };
+
+        /**
+         * @brief The order of the ports in the index, first by the name pattern and then by the device path
+         */
+        static bool entryBefore(const indexEntry& lhs, const indexEntry& rhs) noexcept;
+
+        /// Protects all members
+        std::mutex indexMutex;
+
+        /// All known ports, sorted with entryBefore
+        std::vector<indexEntry> ports;
+
+        /// The shared hot plug monitor, nullptr if device changes cannot be monitored
+        std::shared_ptr<RS232_hotplugMonitor> hotplugMonitor;
+
+        /// Set by the hot plug monitor, the devices are only scanned again if this is true
+        std::atomic<bool> devicesChanged = true;
+
+        /**
+         * @brief The platform specific function to find all available ports
+         * @param entries is filled with the device paths and node ids in a single pass over the devices
+         */
+        static void scanPorts(std::vector<indexEntry>& entries);
+
+        /**
+         * @brief The platform specific function to fill in the metadata of a newly found port
+         * @param info the port, only the device path is set when this is called
+         */
+        static void readPortInfo(portInfo& info);
+
+        /**
+         * @brief Scan the devices if something changed and update the index
+         * The caller has to hold the indexMutex.
+         */
+        void update();
+
+        /**
+         * @brief Collect all ports for which the predicate returns true
+         * @tparam Predicate the type of the function that selects the ports
+         * @param predicate returns true for every port that should be returned
+         */
+        template <typename Predicate>
+        std::vector<portInfo> collectPorts(Predicate&& predicate) {
+            std::scoped_lock lock{indexMutex};
+            update();
+
+            std::vector<portInfo> matches;
+            for (const auto& entry : ports) {
+                if (predicate(entry.info)) {
+                    matches.push_back(entry.info);
+                }
+            }
+            return matches;
+        }
+
+      public:
+        /**
+         * @brief Construct a new index and subscribe to the hot plug monitor if it is available
+         */
+        RS232_portIndex();
+
+        /**
+         * @brief Unsubscribe from the hot plug monitor
+         */
+        ~RS232_portIndex();
+
+        RS232_portIndex(const RS232_portIndex&)            = delete;
+        RS232_portIndex& operator=(const RS232_portIndex&) = delete;
+
+        /**
+         * @brief Get the index that is shared by the whole process
+         * The index (and its subscription to the hot plug monitor) only lives as long as somebody holds the returned pointer.
+         * Keep the pointer to answer repeated queries from the cache.
+         * @return std::shared_ptr<RS232_portIndex> the shared index, it is created if it does not exist yet
+         */
+        [[nodiscard]]
+        static std::shared_ptr<RS232_portIndex> getShared();
+
+        /**
+         * @brief Get the device paths of all available ports, this is used by getAvailablePorts
+         * If the shared index exists, the answer comes from its cache. Otherwise the devices are scanned once without creating
+         * an index, so the call has no lasting side effects.
+         */
+        [[nodiscard]]
+        static std::vector<std::string> listPortPaths();
+
+        /**
+         * @brief Update the index now
+         * This is done by all other functions automatically, calling it directly is only useful to take the cost of the first scan
+         * at a convenient time.
+         */
+        void refresh();
+
+        /**
+         * @brief Get all available ports
+         */
+        [[nodiscard]]
+        std::vector<portInfo> getPorts();
+
+        /**
+         * @brief Get the device paths of all available ports
+         */
+        [[nodiscard]]
+        std::vector<std::string> getPortPaths();
+
+        /**
+         * @brief Find all ports of an USB adapter
+         * @param vendorId the USB vendor id of the adapter
+         * @param productId the USB product id of the adapter, 0 matches any product of the vendor
+         */
+        [[nodiscard]]
+        std::vector<portInfo> findByUsbId(uint16_t vendorId, uint16_t productId = 0);
+
+        /**
+         * @brief Find all ports of the USB adapter with the given serial number
+         */
+        [[nodiscard]]
+        std::vector<portInfo> findBySerialNumber(std::string_view serialNumber);
+
+        /**
+         * @brief Find all ports that use the given kernel driver
+         */
+        [[nodiscard]]
+        std::vector<portInfo> findByDriver(std::string_view driver);
+    };
+
+} // namespace sakurajin
+
+#endif // SAKURAJIN_RS232_PORTINDEX_HPP_INCLUDED
@@ -0,0 +1,115 @@
+#ifndef SAKURAJIN_RS232_REACTOR_HPP_INCLUDED
+#define SAKURAJIN_RS232_REACTOR_HPP_INCLUDED
+
+#include "rs232_native.hpp"
+
+#include <future>
+
+namespace sakurajin {
+
+    class RS232;
+
+    /**
+     * @brief A shared io context that serves many RS232 objects with a small fixed number of threads.
+     * By default every RS232 object starts its own work thread.
+     * If a reactor is passed in the RS232_settings, the object is instead registered with one of the reactor threads.
+     * Each reactor thread waits for the current devices of all its objects with a single call to waitForEvents and then handles
+     * the objects that have something to do.
+     * The buffers of the RS232 objects are still completely separate, only the threads are shared.
+     *
+     * The reactor is passed as shared pointer, so it is kept alive until the last RS232 object using it is destroyed.
+     */
+    class RS232_EXPORT_MACRO RS232_reactor {
+      private:
+        /**
+         * @brief An object that is served by a thread of the reactor
+         * The id is unique for every registration, so an object that is created at the address of a removed object is never
+         * mistaken for the removed one.
+         */
+        struct registration {
+            RS232*   instance = nullptr;
+            uint64_t id       = 0;
+        };
+
+        /**
+         * @brief A single thread of the reactor and the objects it serves
+         */
+        struct worker {
+            /// The wakeup handle of this thread, it is used by all registered objects
+            RS232_wakeup wakeup;
+
+            /// The mutex that protects the list of objects and is held while the objects are handled
+            std::mutex instanceMutex;
+
+            /// The objects that are served by this thread
+            std::vector<registration> instances;
+
+            /// Incremented every time an object is removed, used to detect removals during a wait
+            size_t generation = 0;
+
+            /// The actual thread
+            std::future<void> thread;
+        };
+
+        /// All threads of this reactor
+        std::vector<std::unique_ptr<worker>> workers;
+
+        /// Set to true when the reactor is destroyed
+        std::atomic<bool> stopThreads = false;
+
+        /// The id of the next registration
+        std::atomic<uint64_t> nextRegistrationId = 0;
+
+        /**
+         * @brief The loop that is executed by each reactor thread
+         * @param self the worker the thread belongs to
+         */
+        void run(worker& self);
+
+        /**
+         * @brief Register an object with the least busy thread
+         * The wakeup handles of the object are set to the one of that thread before the thread can see the object.
+         * @param instance the object that should be served by this reactor
+         */
+        void addInstance(RS232* instance);
+
+        /**
+         * @brief Remove an object from the reactor
+         * When this returns the object is not accessed by any reactor thread anymore.
+         * @param instance the object that should be removed
+         */
+        void removeInstance(RS232* instance);
+
+        friend class RS232;
+
+      public:
+        /**
+         * @brief Construct a new reactor and start its threads
+         * @param threadCount the number of threads that serve the registered objects, values smaller than 1 are set to 1
+         */
+        explicit RS232_reactor(size_t threadCount = 1);
+
+        /**
+         * @brief Stop all threads of the reactor
+         */
+        ~RS232_reactor();
+
+        RS232_reactor(const RS232_reactor&)            = delete;
+        RS232_reactor& operator=(const RS232_reactor&) = delete;
+
+        /**
+         * @brief Get the number of threads used by this reactor
+         */
+        [[nodiscard]] [[maybe_unused]]
+        size_t getThreadCount() const noexcept;
+
+        /**
+         * @brief Get the number of RS232 objects that are currently served by this reactor
+         */
+        [[nodiscard]] [[maybe_unused]]
+        size_t getInstanceCount();
+    };
+
+} // namespace sakurajin
+
+#endif // SAKURAJIN_RS232_REACTOR_HPP_INCLUDED
@@ -0,0 +1,96 @@
+#ifndef SAKURAJIN_RS232_RINGBUFFER_HPP_INCLUDED
+#define SAKURAJIN_RS232_RINGBUFFER_HPP_INCLUDED
+
+#ifndef RS232_EXPORT_MACRO
+    #define RS232_EXPORT_MACRO
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace sakurajin {
+
+    /**
+     * @brief A fixed capacity lock free byte ring for exactly one producer and one consumer thread.
+     * The RS232 wrapper uses this as an alternative to the read buffer string.
+     * The work thread pushes the received chunks and the user drains them into their own buffer.
+     * Neither side ever locks a mutex or allocates memory after the construction.
+     *
+     * The head is only written by the producer and the tail only by the consumer.
+     * Both are placed on separate cache lines to prevent the two threads from invalidating each others cache.
+     * Each side also keeps a cached copy of the other index, so the shared index only has to be loaded when the cached one is
+     * not sufficient anymore.
+     */
+    class RS232_EXPORT_MACRO RS232_ringBuffer {
+      private:
+        /// The assumed size of a cache line, used to separate the indices
+        static constexpr size_t cacheLineSize = 64;
+
+        /// The actual storage of the ring, the size is always a power of two
+        std::unique_ptr<char[]> storage;
+
+        /// The capacity of the storage minus one, used to map the indices into the storage
+        size_t mask;
+
+        /// The total number of bytes ever pushed, only written by the producer
+        alignas(cacheLineSize) std::atomic<size_t> head = 0;
+        /// The last known value of tail, only used by the producer
+        size_t cachedTail = 0;
+
+        /// The total number of bytes ever popped, only written by the consumer
+        alignas(cacheLineSize) std::atomic<size_t> tail = 0;
+        /// The last known value of head, only used by the consumer
+        size_t cachedHead = 0;
+
+      public:
+        /**
+         * @brief Construct a new ring buffer
+         * @param capacity the minimal number of bytes the ring can hold, this is rounded up to the next power of two
+         */
+        explicit RS232_ringBuffer(size_t capacity);
+
+        RS232_ringBuffer(const RS232_ringBuffer&)            = delete;
+        RS232_ringBuffer& operator=(const RS232_ringBuffer&) = delete;
+
+        /**
+         * @brief Get the number of bytes the ring can hold
+         */
+        [[nodiscard]]
+        size_t capacity() const noexcept;
+
+        /**
+         * @brief Get the number of bytes that are currently stored in the ring
+         * @note if called while the other side is active, the value may be outdated immediately.
+         */
+        [[nodiscard]]
+        size_t size() const noexcept;
+
+        /**
+         * @brief Check if the ring contains no data
+         */
+        [[nodiscard]]
+        bool empty() const noexcept;
+
+        /**
+         * @brief Copy data into the ring
+         * @warning this may only be called by the producer thread.
+         * @param data the data that should be added
+         * @param length the number of bytes in data
+         * @return size_t the number of bytes that were added, this is less than length if the ring is full
+         */
+        size_t push(const char* data, size_t length) noexcept;
+
+        /**
+         * @brief Move data from the ring into a caller provided buffer
+         * @warning this may only be called by the consumer thread.
+         * @param destination the buffer the data is copied to
+         * @param length the size of the destination buffer
+         * @return size_t the number of bytes that were copied
+         */
+        size_t pop(char* destination, size_t length) noexcept;
+    };
+
+} // namespace sakurajin
+
+#endif // SAKURAJIN_RS232_RINGBUFFER_HPP_INCLUDED
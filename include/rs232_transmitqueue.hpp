@@ -0,0 +1,125 @@
+#ifndef SAKURAJIN_RS232_TRANSMITQUEUE_HPP_INCLUDED
+#define SAKURAJIN_RS232_TRANSMITQUEUE_HPP_INCLUDED
+
+#ifndef RS232_EXPORT_MACRO
+    #define RS232_EXPORT_MACRO
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace sakurajin {
+
+    /**
+     * @brief A lock free queue of messages with many producers and a single consumer.
+     * The RS232 wrapper uses this to pass the messages from Print to the work thread.
+     * Any number of threads can push messages at the same time without waiting for each other.
+     * The messages of each producer are always consumed in the order they were pushed.
+     *
+     * The nodes of the queue are pooled.
+     * After a message was consumed its node (including the capacity of its string) is put on a free list and reused by the next push.
+     * New nodes are only allocated if the free list is empty, so the pool grows to the number of messages that are in flight at the
+     * same time.
+     */
+    class RS232_EXPORT_MACRO RS232_transmitQueue {
+      private:
+        struct node {
+            /// The next node in the queue, set by the producer that pushed the following node
+            std::atomic<node*> next = nullptr;
+            /// The next node in the free list, only valid while the node is in the free list
+            node* nextFree = nullptr;
+            /// The message that should be transmitted
+            std::string message;
+        };
+
+        /// The node that was pushed last, producers exchange this to add a new node
+        std::atomic<node*> head;
+
+        /// The oldest node in the queue, only used by the consumer
+        node* tail;
+
+        /// A placeholder node that is in the queue whenever it would otherwise be empty
+        node stub;
+
+        /// The first node of the free list
+        std::atomic<node*> freeList = nullptr;
+
+        /**
+         * @brief Get a node from the pool or allocate a new one if the pool is empty
+         */
+        node* acquireNode();
+
+        /**
+         * @brief Put a list of nodes (linked with nextFree) back into the pool
+         * @param first the first node of the list
+         * @param last the last node of the list
+         */
+        void releaseNodes(node* first, node* last) noexcept;
+
+        /**
+         * @brief Link a node into the queue, this is safe to call from any thread
+         */
+        void pushNode(node* newNode) noexcept;
+
+        /**
+         * @brief Remove the oldest node from the queue
+         * @return node* the oldest node or nullptr if the queue is empty or a producer did not finish linking its node yet
+         */
+        node* popNode() noexcept;
+
+      public:
+        RS232_transmitQueue();
+        ~RS232_transmitQueue();
+
+        RS232_transmitQueue(const RS232_transmitQueue&)            = delete;
+        RS232_transmitQueue& operator=(const RS232_transmitQueue&) = delete;
+
+        /**
+         * @brief Add a message to the end of the queue
+         * This can be called from any thread.
+         * @param message the message that should be added
+         */
+        void push(std::string message);
+
+        /**
+         * @brief Add a message that consists of several segments to the end of the queue
+         * The segments are copied into a single pooled node, so once the pool is warm this does not allocate.
+         * This can be called from any thread.
+         * @param segments the parts of the message, in order
+         * @param count the number of segments
+         */
+        void pushSegments(const std::string_view* segments, size_t count);
+
+        /**
+         * @brief Move all queued messages into a single buffer
+         * The messages are appended to the destination in the order they were pushed.
+         * @warning this may only be called by the consumer thread.
+         * @param destination the buffer the messages should be appended to
+         * @param maxLength stop taking further messages once the destination is at least this long
+         * @return size_t the number of messages that were appended
+         */
+        size_t drainInto(std::string& destination, size_t maxLength = SIZE_MAX);
+
+        /**
+         * @brief Remove the oldest messages from the queue without consuming them
+         * Only whole messages are removed, so the last removed message can take the total above length.
+         * @warning this may only be called by the consumer thread.
+         * @param length the number of bytes that should be removed at least
+         * @return size_t the number of bytes that were removed, this is less than length if the queue ran empty
+         */
+        size_t dropOldest(size_t length);
+
+        /**
+         * @brief Check if there are messages in the queue
+         * @warning this may only be called by the consumer thread.
+         */
+        [[nodiscard]]
+        bool empty() const noexcept;
+    };
+
+} // namespace sakurajin
+
+#endif // SAKURAJIN_RS232_TRANSMITQUEUE_HPP_INCLUDED
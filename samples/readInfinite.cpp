@@ -53,12 +53,14 @@ int main (int argc, char **argv) {
             }
         }
     }else{
+        //the string is swapped with the read buffer on every call, so after a few calls no memory is allocated anymore
+        std::string readString;
         while(true){
             //do a small delay to prevent too much locking
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
 
-            //read the string and save the result in a variable
-            auto readString = rs232_interface.retrieveReadBuffer();
+            //exchange the read buffer with the string, the old content of the string is discarded
+            rs232_interface.swapReadBuffer(readString);
 
             //output the string to the console
             std::cout << readString << std::flush;
@@ -1,19 +1,234 @@
 #include "rs232.hpp"
 
+#include <climits>
+#include <cstring>
+#include <sstream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define RS232_USE_SSE2
+    #include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    #define RS232_USE_NEON
+    #include <arm_neon.h>
+#endif
+
 using namespace std::literals;
 
+/**
+ * @brief find the first byte in [begin, end) that is one of the delimiters
+ * A single delimiter is searched with memchr, which is already vectorized by the c library.
+ * For multiple delimiters 16 bytes are compared against all delimiters at once with SSE2 or NEON if available.
+ * @return const char* the position of the delimiter or end if there is none
+ */
+static const char* findDelimiter(const char* begin, const char* end, std::string_view delimiters) noexcept {
+    if (delimiters.size() == 1) {
+        auto found = std::memchr(begin, delimiters.front(), static_cast<size_t>(end - begin));
+        return found == nullptr ? end : static_cast<const char*>(found);
+    }
+
+#if defined(RS232_USE_SSE2)
+    for (; end - begin >= 16; begin += 16) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        auto found = _mm_setzero_si128();
+        for (auto delimiter : delimiters) {
+            found = _mm_or_si128(found, _mm_cmpeq_epi8(block, _mm_set1_epi8(delimiter)));
+        }
+
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(found));
+        if (mask != 0) {
+            unsigned offset = 0;
+            while ((mask & 1U) == 0) {
+                mask >>= 1U;
+                offset++;
+            }
+            return begin + offset;
+        }
+    }
+#elif defined(RS232_USE_NEON)
+    for (; end - begin >= 16; begin += 16) {
+        auto block = vld1q_u8(reinterpret_cast<const uint8_t*>(begin));
+        auto found = vdupq_n_u8(0);
+        for (auto delimiter : delimiters) {
+            found = vorrq_u8(found, vceqq_u8(block, vdupq_n_u8(static_cast<uint8_t>(delimiter))));
+        }
+
+        // the exact position is found by the scalar loop below
+        if (vmaxvq_u8(found) != 0) {
+            break;
+        }
+    }
+#endif
+
+    // the remaining bytes (or all bytes without simd support)
+    for (; begin < end; begin++) {
+        if (delimiters.find(*begin) != std::string_view::npos) {
+            return begin;
+        }
+    }
+
+    return end;
+}
+
+/**
+ * @brief Move pending entries into a store while respecting the receive capacity and overflow policy
+ * This is used for the decoded frames and the fan in chunks, the caller has to hold the mutex of the store.
+ * @param stored the entries that can be retrieved by the consumer
+ * @param storedSize the total size of the stored entries
+ * @param pending the entries that should be stored, entries that have to wait for the consumer are kept
+ * @param entrySize returns the number of bytes of an entry
+ */
+template <typename Entry, typename SizeFunction>
+static void storeBoundedEntries(std::vector<Entry>&       stored,
+                                size_t&                   storedSize,
+                                std::vector<Entry>&       pending,
+                                size_t                    capacity,
+                                sakurajin::overflowPolicy policy,
+                                std::atomic<uint64_t>&    droppedBytes,
+                                SizeFunction              entrySize) {
+    if (capacity == 0) {
+        for (const auto& entry : pending) {
+            storedSize += entrySize(entry);
+        }
+
+        if (stored.empty()) {
+            std::swap(stored, pending);
+        } else {
+            std::move(pending.begin(), pending.end(), std::back_inserter(stored));
+        }
+        pending.clear();
+        return;
+    }
+
+    size_t handled = 0;
+    for (; handled < pending.size(); handled++) {
+        auto& entry = pending[handled];
+        auto  size  = entrySize(entry);
+
+        // a single entry that is larger than the capacity is only accepted into an empty store by the blocking policy
+        bool fits = storedSize + size <= capacity || (stored.empty() && policy == sakurajin::blockOnOverflow);
+        if (!fits && policy == sakurajin::dropOldest) {
+            // remove as many of the oldest entries as needed at once
+            size_t removed = 0;
+            while (removed < stored.size() && storedSize + size > capacity) {
+                storedSize -= entrySize(stored[removed]);
+                droppedBytes += entrySize(stored[removed]);
+                removed++;
+            }
+            stored.erase(stored.begin(), stored.begin() + static_cast<std::ptrdiff_t>(removed));
+            fits = storedSize + size <= capacity;
+        }
+
+        if (fits) {
+            storedSize += size;
+            stored.emplace_back(std::move(entry));
+            continue;
+        }
+
+        // with the blocking policy the remaining entries are kept until the consumer made room for them
+        if (policy == sakurajin::blockOnOverflow) {
+            break;
+        }
+        droppedBytes += size;
+    }
+
+    pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(handled));
+}
+
+/**
+ * @brief The shared state of a parallel connection attempt
+ * It is shared with the threads that open the devices, since they can outlive the Connect call (and the RS232 object) on a timeout.
+ */
+struct sakurajin::RS232::connectAttempt {
+    enum attemptState {
+        /// the device is still being opened or probed
+        running,
+        /// the device is connected and was accepted by the probe
+        accepted,
+        /// the device could not be used, it is not connected anymore
+        rejected,
+        /// the attempt timed out and is still running, the device is closed once it finishes
+        abandoned
+    };
+
+    std::mutex                            mutex;
+    std::condition_variable               finished;
+    std::vector<attemptState>             results;
+    std::chrono::steady_clock::time_point deadline;
+    /// true for every device that is opened by this attempt, the others were connected already or skipped
+    std::vector<bool> started;
+    /// the error messages of every device, they are collected by the threads and written to the error stream of the object
+    std::vector<std::string> errors;
+
+    /// check if no device is running anymore, the caller has to hold the mutex
+    [[nodiscard]]
+    bool allFinished() const {
+        return std::none_of(results.begin(), results.end(), [](attemptState state) { return state == running; });
+    }
+
+    /// give up on the devices that are still running, the caller has to hold the mutex
+    void abandonRunning() {
+        for (auto& state : results) {
+            if (state == running) {
+                state = abandoned;
+            }
+        }
+    }
+};
+
+/**
+ * @brief Wakes up the thread that handles the read stage if it waits for space in the receive store
+ */
+struct sakurajin::RS232::receiveSpaceGuard {
+    RS232& owner;
+
+    ~receiveSpaceGuard() {
+        if (owner.receiveSpaceWanted.exchange(false)) {
+            owner.readerWakeup->notify();
+        }
+    }
+};
+
 // constructors and destructors
-sakurajin::RS232::RS232(const std::vector<std::string>& deviceNames, sakurajin::Baudrate baudrate, std::ostream& errorStream) {
+sakurajin::RS232::RS232(const std::vector<std::string>& deviceNames,
+                        sakurajin::Baudrate             baudrate,
+                        std::ostream&                   errorStream,
+                        const RS232_settings&           settings) {
+    if (settings.receiveRingCapacity > 0) {
+        receiveRing = std::make_unique<RS232_ringBuffer>(settings.receiveRingCapacity);
+    } else if (settings.receiveRope) {
+        receiveRope = std::make_unique<RS232_chunkRope>();
+    }
+    frameDecoder       = settings.frameDecoder;
+    receiveCapacity    = settings.receiveCapacity;
+    receivePolicy      = settings.receiveOverflowPolicy;
+    transmitCapacity   = settings.transmitCapacity;
+    transmitPolicy     = settings.transmitOverflowPolicy;
+    connectTimeout     = settings.connectTimeout;
+    probe              = settings.probe;
+    fanIn              = settings.fanIn;
+    this->errorStream  = &errorStream;
+    closeUnusedDevices = settings.closeUnusedDevices && !settings.fanIn;
+
     if (deviceNames.empty()) {
         errorStream << "No device name was given. Creating empty RS232 object.";
         return;
     }
 
-    // add all devices to the list
+    // add all devices to the list, the ports are opened in parallel by Connect
     rs232Devices.reserve(deviceNames.size());
     for (const auto& deviceName : deviceNames) {
         try {
-            rs232Devices.emplace_back(std::make_shared<sakurajin::RS232_native>(deviceName, baudrate, errorStream));
+            if (settings.customBaudrate != 0) {
+                rs232Devices.emplace_back(std::make_shared<sakurajin::RS232_native>(
+                    deviceName, settings.customBaudrate, errorStream, settings.lineConfig, false));
+            } else {
+                rs232Devices.emplace_back(
+                    std::make_shared<sakurajin::RS232_native>(deviceName, baudrate, errorStream, settings.lineConfig, false));
+            }
+
+            if (settings.lowLatency) {
+                rs232Devices.back()->setLowLatency(true, 1, errorStream);
+            }
         } catch (...) {
             for (auto& device : rs232Devices) {
                 device->disconnect();
@@ -23,154 +238,1082 @@ sakurajin::RS232::RS232(const std::vector<std::string>& deviceNames, sakurajin::
         }
     }
 
-    Connect();
+    broadcastJobs.resize(rs232Devices.size());
+    connectsInFlight = std::make_shared<std::vector<std::atomic<bool>>>(rs232Devices.size());
 
-    // start the work thread
-    workThread = std::async(std::launch::async, [this]() {
-        while (!stopThread) {
-            work();
-        }
-    });
+    // devices that are missing now are connected by the threads once they appear
+    // in fan in mode that is also done for every device that is not connected yet
+    autoReconnect    = settings.autoReconnect;
+    bool connected   = Connect();
+    reconnectPending = autoReconnect && (!connected || (fanIn && anyDeviceDisconnected()));
+
+    // the monitor has to be known before any thread starts, since the threads reconnect the devices
+    if (autoReconnect) {
+        hotplugMonitor = RS232_hotplugMonitor::getShared();
+    }
+
+    if (settings.reactor != nullptr && !fanIn) {
+        // let the reactor serve this object if one is given
+        reactor = settings.reactor;
+        reactor->addInstance(this);
+    } else if (!settings.separateWriteThread) {
+        // start the work thread, it handles both stages unless a separate write thread is requested
+        workThread = std::async(std::launch::async, [this]() {
+            while (!stopThread) {
+                work(ioReadable | ioWritable, wakeup);
+            }
+        });
+    } else {
+        workerWakeup = &writeWakeup;
+        workThread   = std::async(std::launch::async, [this]() {
+            while (!stopThread) {
+                work(ioReadable, wakeup);
+            }
+        });
+        writeThread = std::async(std::launch::async, [this]() {
+            while (!stopThread) {
+                work(ioWritable, writeWakeup);
+            }
+        });
+    }
+
+    if (hotplugMonitor != nullptr) {
+        hotplugMonitor->subscribe(&devicesChanged, readerWakeup);
+    }
 }
 
-sakurajin::RS232::RS232(const std::string& deviceName, sakurajin::Baudrate Rate, std::ostream& errorStream)
-    : RS232(std::vector<std::string>{deviceName}, Rate, errorStream) {}
+sakurajin::RS232::RS232(const std::string&    deviceName,
+                        sakurajin::Baudrate   Rate,
+                        std::ostream&         errorStream,
+                        const RS232_settings& settings)
+    : RS232(std::vector<std::string>{deviceName}, Rate, errorStream, settings) {}
 
 [[maybe_unused]]
-sakurajin::RS232::RS232(sakurajin::Baudrate Rate, std::ostream& errorStream)
-    : RS232(sakurajin::getAvailablePorts(), Rate, errorStream) {}
+sakurajin::RS232::RS232(sakurajin::Baudrate Rate, std::ostream& errorStream, const RS232_settings& settings)
+    : RS232(sakurajin::getAvailablePorts(), Rate, errorStream, settings) {}
 
 sakurajin::RS232::~RS232() {
     // correctly stop the work thread before disconnecting everything
     stopThread = true;
+    if (hotplugMonitor != nullptr) {
+        hotplugMonitor->unsubscribe(&devicesChanged);
+    }
+    if (reactor != nullptr) {
+        reactor->removeInstance(this);
+    }
+
+    wakeup.notify();
+    writeWakeup.notify();
+    {
+        // release all Print calls that wait for space in the transmit buffer
+        std::scoped_lock lock{transmitSpaceMutex};
+        transmitSpaceCondition.notify_all();
+    }
     if (workThread.valid()) {
         workThread.wait();
     }
+    if (writeThread.valid()) {
+        writeThread.wait();
+    }
+
+    {
+        // nothing writes the remaining broadcast messages anymore
+        std::scoped_lock lock{broadcastMutex};
+        for (size_t i = 0; i < broadcastJobs.size(); i++) {
+            failBroadcasts(i);
+        }
+    }
+
+    // a reconnection attempt that is still running closes its devices once it finishes
+    if (reconnectAttempt != nullptr) {
+        std::scoped_lock lock{reconnectAttempt->mutex};
+        reconnectAttempt->abandonRunning();
+    }
 
     DisconnectAll();
 }
 
 // connection functions
+sakurajin::RS232_probe
+sakurajin::makeResponseProbe(std::string request, std::string expectedResponse, std::chrono::milliseconds timeout) {
+    return [request = std::move(request), expected = std::move(expectedResponse), timeout](RS232_native& device) {
+        auto deadline  = std::chrono::steady_clock::now() + timeout;
+        auto remaining = [deadline]() {
+            return std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        };
+
+        size_t written = 0;
+        while (written < request.size()) {
+            auto chunkLength = static_cast<int>(std::min<size_t>(request.size() - written, INT_MAX));
+            auto writeLength = device.writeRawData(request.data() + written, chunkLength);
+            if (writeLength < 0) {
+                return false;
+            }
+            written += static_cast<size_t>(writeLength);
+            if (written == request.size()) {
+                break;
+            }
+
+            ioWaitEntry entry{&device, ioWritable};
+            if (remaining().count() <= 0 || waitForEvents(&entry, 1, nullptr, remaining()) < 0 || (entry.returned & ioError) != 0) {
+                return false;
+            }
+        }
+
+        std::string response;
+        char        buffer[256];
+        while (response.find(expected) == std::string::npos) {
+            auto timeLeft = remaining();
+            if (timeLeft.count() <= 0) {
+                return false;
+            }
+
+            auto readLength = device.readRawDataTimed(buffer, sizeof(buffer), timeLeft);
+            if (readLength < 0) {
+                return false;
+            }
+            response.append(buffer, static_cast<size_t>(readLength));
+        }
+        return true;
+    };
+}
+
 bool sakurajin::RS232::Connect() {
     if (rs232Devices.empty()) {
         return false;
     }
 
+    std::scoped_lock connectLock{connectMutex};
+
     // return early if the current device is already connected
-    if (getCurrentDevice()->getConnectionStatus() == sakurajin::connectionStatus::connected) {
+    // in fan in mode the other devices are used as well, so they are connected anyway
+    if (getCurrentDevice()->getConnectionStatus() == sakurajin::connectionStatus::connected && !connectInFlight(currentDevice) && !fanIn) {
         return true;
     }
 
-    // connect all devices
-    for (auto& device : rs232Devices) {
-        device->connect();
+    auto attempt = startConnectAttempt();
+    {
+        std::unique_lock lock{attempt->mutex};
+        attempt->finished.wait_until(lock, attempt->deadline, [&attempt]() { return attempt->allFinished(); });
     }
 
-    // find the first connected device or a device that can be connected to but is disconnected at the moment
+    return finishConnectAttempt(attempt);
+}
+
+std::shared_ptr<sakurajin::RS232::connectAttempt> sakurajin::RS232::startConnectAttempt() {
+    auto attempt = std::make_shared<connectAttempt>();
+    attempt->results.resize(rs232Devices.size(), connectAttempt::running);
+    attempt->started.resize(rs232Devices.size(), false);
+    attempt->errors.resize(rs232Devices.size());
+
+    // devices that are still busy with a timed out attempt are skipped and devices that are already connected are used as they are
     for (size_t i = 0; i < rs232Devices.size(); i++) {
-        switch (rs232Devices[i]->getConnectionStatus()) {
-            case sakurajin::connectionStatus::connected:
-                currentDevice = i;
-                return true;
-            case sakurajin::connectionStatus::disconnected:
-                currentDevice = i;
-            case sakurajin::connectionStatus::otherError:
-            case sakurajin::connectionStatus::portNotFound:
-                break;
-            default:
-                throw std::runtime_error("unknown connection status");
+        if ((*connectsInFlight)[i]) {
+            attempt->results[i] = connectAttempt::rejected;
+            continue;
+        }
+
+        if (rs232Devices[i]->getConnectionStatus() == sakurajin::connectionStatus::connected) {
+            attempt->results[i] = connectAttempt::accepted;
+        }
+    }
+
+    // open all other devices at the same time, opening some usb adapters takes hundreds of milliseconds
+    attempt->deadline = std::chrono::steady_clock::now() + connectTimeout;
+    for (size_t i = 0; i < rs232Devices.size(); i++) {
+        if (attempt->results[i] != connectAttempt::running) {
+            continue;
+        }
+
+        // the flag is set before the thread starts and reset by the thread once it does not touch the device anymore
+        (*connectsInFlight)[i] = true;
+        attempt->started[i]    = true;
+        try {
+            std::thread([attempt, i, device = rs232Devices[i], deviceProbe = probe, inFlight = connectsInFlight]() {
+                // the thread can outlive the object, so it never writes to the error stream of the object directly
+                std::ostringstream errors;
+                bool               usable = device->connect(errors) == sakurajin::connectionStatus::connected;
+                if (usable && deviceProbe) {
+                    try {
+                        usable = deviceProbe(*device);
+                    } catch (const std::exception& e) {
+                        errors << "the probe of " << device->getDeviceName() << " failed: " << e.what() << std::endl;
+                        usable = false;
+                    } catch (...) {
+                        errors << "the probe of " << device->getDeviceName() << " failed" << std::endl;
+                        usable = false;
+                    }
+                    if (!usable) {
+                        device->disconnect();
+                    }
+                }
+
+                std::unique_lock lock{attempt->mutex};
+                if (attempt->results[i] == connectAttempt::abandoned) {
+                    // nobody waits for this device anymore, so it is closed before it is marked as free again
+                    lock.unlock();
+                    device->disconnect();
+                    lock.lock();
+                    usable = false;
+                }
+                attempt->results[i] = usable ? connectAttempt::accepted : connectAttempt::rejected;
+                attempt->errors[i]  = errors.str();
+                (*inFlight)[i]      = false;
+                lock.unlock();
+                attempt->finished.notify_all();
+            }).detach();
+        } catch (...) {
+            std::scoped_lock lock{attempt->mutex};
+            attempt->results[i]    = connectAttempt::rejected;
+            (*connectsInFlight)[i] = false;
+        }
+    }
+
+    return attempt;
+}
+
+bool sakurajin::RS232::finishConnectAttempt(const std::shared_ptr<connectAttempt>& attempt) {
+    // the devices that are still running are closed by their threads once they finish
+    std::vector<connectAttempt::attemptState> results;
+    std::vector<std::string>                  errors;
+    {
+        std::scoped_lock lock{attempt->mutex};
+        attempt->abandonRunning();
+        results = attempt->results;
+        errors  = attempt->errors;
+    }
+
+    for (const auto& message : errors) {
+        *errorStream << message;
+    }
+
+    // keep the current device if it was accepted, otherwise use the first accepted device
+    // or a device that can be connected to but is disconnected at the moment
+    bool connected = results[currentDevice] == connectAttempt::accepted;
+    for (size_t i = 0; i < rs232Devices.size() && !connected; i++) {
+        if (results[i] == connectAttempt::accepted) {
+            currentDevice = i;
+            connected     = true;
+        } else if (results[i] == connectAttempt::rejected && !probe &&
+                   rs232Devices[i]->getConnectionStatus() == sakurajin::connectionStatus::disconnected) {
+            currentDevice = i;
         }
     }
 
-    // no device was connected successfully so return false
-    return false;
+    // the other ports this attempt opened are released for other programs if the user only wants the current device
+    if (closeUnusedDevices) {
+        for (size_t i = 0; i < rs232Devices.size(); i++) {
+            if (i != currentDevice && attempt->started[i] && results[i] == connectAttempt::accepted) {
+                rs232Devices[i]->disconnect();
+            }
+        }
+    }
+
+    return connected;
 }
 
 void sakurajin::RS232::DisconnectAll() {
+    // the devices were disconnected on purpose, so they should not be reconnected automatically
+    reconnectPending = false;
+
     for (const auto& device : rs232Devices) {
         device->disconnect();
     }
 }
 
+bool sakurajin::RS232::changeLineConfiguration(const lineConfiguration& config, std::ostream& errorStream) {
+    if (rs232Devices.empty()) {
+        return false;
+    }
+
+    // the devices that are not connected only store the configuration, they use it once they are connected
+    for (const auto& device : rs232Devices) {
+        device->changeLineConfiguration(config, errorStream, device->getConnectionStatus() == sakurajin::connectionStatus::connected);
+    }
+
+    return IsAvailable();
+}
+
 // the work function
-void sakurajin::RS232::work() {
+void sakurajin::RS232::work(int stages, RS232_wakeup& threadWakeup) {
+    // in fan in mode the read stage waits for all devices at once
+    if (fanIn && (stages & ioReadable) != 0) {
+        workFanIn(stages, threadWakeup);
+        return;
+    }
+
+    // the first entry is the current device, the broadcast messages add an entry for every device they are written to.
+    // These are only used by this thread and reused for every call to keep their capacity.
+    thread_local std::vector<ioWaitEntry> entries;
+    thread_local std::vector<size_t>      indices;
+
+    std::shared_ptr<RS232_native> transferDevice;
+    ioWaitEntry                   entry;
+
+    auto timeout = prepareWait(transferDevice, entry, stages);
+
+    entries.clear();
+    indices.clear();
+    entries.push_back(entry);
+    indices.push_back(currentDevice);
+    if ((stages & ioWritable) != 0) {
+        prepareBroadcastWait(indices, entries);
+    }
+
+    if (waitForEvents(entries.data(), entries.size(), &threadWakeup, timeout) < 0) {
+        std::cerr << "Error while waiting for the device" << std::endl;
+        return;
+    }
+
+    handleEvents(transferDevice, entries.front().returned, stages);
+    handleBroadcastEvents(indices.data() + 1, entries.data() + 1, entries.size() - 1);
+}
+
+void sakurajin::RS232::workFanIn(int stages, RS232_wakeup& threadWakeup) {
+    // the current device is prepared like in work, so reconnecting, failover and the write stage behave the same way
+    std::shared_ptr<RS232_native> transferDevice;
+    ioWaitEntry                   entry;
+    auto                          timeout = prepareWait(transferDevice, entry, stages);
+
+    // with a limited receive buffer nothing new is read while chunks are still waiting for space,
+    // retrieveChunks and swapChunks wake up the thread once they took the stored chunks
+    bool readBlocked = !pendingChunks.empty() && receiveCapacity > 0;
+
+    fanInEntries.clear();
+    fanInIndices.clear();
+    for (size_t i = 0; i < rs232Devices.size(); i++) {
+        // a device that is still opened or probed by a connection attempt belongs to that attempt until it finished
+        const auto& device = rs232Devices[i];
+        if (device->getConnectionStatus() != sakurajin::connectionStatus::connected || connectInFlight(i)) {
+            continue;
+        }
+
+        ioWaitEntry deviceEntry{device.get(), readBlocked ? 0 : ioReadable};
+        if (device == transferDevice) {
+            deviceEntry.requested |= entry.requested & ioWritable;
+        }
+        fanInEntries.push_back(deviceEntry);
+        fanInIndices.push_back(i);
+    }
+
+    auto readEntries = fanInEntries.size();
+    if ((stages & ioWritable) != 0) {
+        prepareBroadcastWait(fanInIndices, fanInEntries);
+    }
+
+    if (waitForEvents(fanInEntries.data(), fanInEntries.size(), &threadWakeup, timeout) < 0) {
+        std::cerr << "Error while waiting for the devices" << std::endl;
+        return;
+    }
+
+    bool currentHandled = false;
+    for (size_t i = 0; i < readEntries; i++) {
+        const auto& device   = rs232Devices[fanInIndices[i]];
+        auto        returned = fanInEntries[i].returned;
+
+        if (device == transferDevice) {
+            // errors and the write stage of the current device are handled like without fan in
+            handleEvents(transferDevice, returned, stages & ioWritable);
+            currentHandled = true;
+        } else if ((returned & ioError) != 0) {
+            // an error on a device that was disconnected on purpose during the wait is ignored,
+            // as is a device that was handed to a new connection attempt in the meantime
+            if (device->getConnectionStatus() == sakurajin::connectionStatus::connected && !connectInFlight(fanInIndices[i])) {
+                std::cerr << "Error on device " << device->getDeviceName() << ", disconnecting it" << std::endl;
+                device->disconnect();
+                reconnectPending = autoReconnect;
+            }
+        }
+
+        if ((returned & ioError) != 0 || (returned & ioReadable) == 0) {
+            continue;
+        }
+
+        // read everything the device has queued (up to the chunk size) and tag it with its device
+        auto chunkSize = std::clamp<size_t>(readChunkSize, 1, INT_MAX);
+        if (readChunk.size() != chunkSize) {
+            readChunk.resize(chunkSize);
+        }
+
+        auto readLength = device->readRawData(readChunk.data(), static_cast<int>(chunkSize));
+        if (readLength > 0) {
+            pendingChunks.push_back(RS232_chunk{
+                fanInIndices[i], std::chrono::steady_clock::now(), std::string(readChunk.data(), static_cast<size_t>(readLength))});
+        }
+    }
+
+    // the transmit limit has to be enforced even if the current device was not waited for
+    if (!currentHandled) {
+        handleEvents(nullptr, 0, stages & ioWritable);
+    }
+
+    handleBroadcastEvents(fanInIndices.data() + readEntries, fanInEntries.data() + readEntries, fanInEntries.size() - readEntries);
+
+    // the flag is set before storing, so chunks that are taken while this thread stores the pending ones still wake it up
+    receiveSpaceWanted = true;
+    publishChunks();
+    receiveSpaceWanted = !pendingChunks.empty();
+}
+
+std::chrono::milliseconds
+sakurajin::RS232::prepareWait(std::shared_ptr<RS232_native>& transferDevice, ioWaitEntry& entry, int stages) {
+    transferDevice = nullptr;
+    entry          = ioWaitEntry{};
+
     if (rs232Devices.empty()) {
         // if there are no devices, wait for 100ms
         // the delay is to prevent the thread from spinning
         // since it is unlikely that a device will be added the delay is higher than for the other cases
-        std::this_thread::sleep_for(100ms);
+        return 100ms;
+    }
+
+    // the thread that handles the read stage also takes care of reconnecting
+    // while an attempt runs in the background, the thread wakes up frequently to pick up its result
+    auto timeout = 100ms;
+    if ((stages & ioReadable) != 0) {
+        tryReconnect();
+        if (reconnectAttempt != nullptr) {
+            timeout = 10ms;
+        }
+    }
+
+    // a device that is still probed by a connection attempt is not used yet
+    auto device = getCurrentDevice();
+    if (device->getConnectionStatus() != sakurajin::connectionStatus::connected || connectInFlight(currentDevice)) {
+        // with automatic reconnection the thread is woken up once a device appears or the next periodic check is due.
+        // Otherwise it is more likely that a device will be connected than that a device will be added,
+        // because of this the wait duration is lower
+        return autoReconnect ? timeout : 1ms;
+    }
+
+    // block until there is something to do
+    // writable is only waited for if there is data to write, otherwise the wait would return immediately.
+    // The timeout is just a fallback, all relevant changes notify the wakeup handle.
+    // That includes the retrieve functions, they wake up the thread once queued data can be stored.
+    transferDevice = std::move(device);
+    entry.device   = transferDevice.get();
+
+    // If the receive buffer is limited, nothing new is read while there is still queued data.
+    // This way the queued data never grows beyond a single chunk and the rest stays in the kernel buffer.
+    if ((stages & ioReadable) != 0) {
+        bool hasQueuedData  = !queuedBuffer.empty() || !pendingFrames.empty();
+        bool receiveLimited = receiveCapacity > 0 || receiveRing != nullptr;
+        if (!hasQueuedData || !receiveLimited) {
+            entry.requested |= ioReadable;
+        }
+    }
+
+    if ((stages & ioWritable) != 0 && (writeOffset < writeBatch.size() || !transmitQueue.empty())) {
+        entry.requested |= ioWritable;
+    }
+
+    return timeout;
+}
+
+void sakurajin::RS232::handleEvents(const std::shared_ptr<RS232_native>& transferDevice, int returned, int stages) {
+    // the limit also has to be enforced while the device is not writable or not connected
+    if ((stages & ioWritable) != 0) {
+        trimTransmitData();
+    }
+
+    if (transferDevice == nullptr) {
+        return;
+    }
+
+    // the device was removed or is not usable anymore
+    // an error on a device that was disconnected on purpose during the wait is ignored
+    if ((returned & ioError) != 0) {
+        if (transferDevice->getConnectionStatus() != sakurajin::connectionStatus::connected) {
+            return;
+        }
+
+        std::cerr << "Error on device " << transferDevice->getDeviceName() << ", disconnecting it" << std::endl;
+        transferDevice->disconnect();
+
+        // try the other devices right away, the lost one is tried again once the hot plug monitor reports a change
+        if (autoReconnect) {
+            reconnectPending = true;
+            devicesChanged   = true;
+            readerWakeup->notify();
+        }
+        return;
+    }
+
+    if ((stages & ioWritable) != 0 && (returned & ioWritable) != 0) {
+        handleWrite(transferDevice);
+    }
+
+    if ((stages & ioReadable) != 0) {
+        handleRead(transferDevice, returned);
+    }
+}
+
+void sakurajin::RS232::handleWrite(const std::shared_ptr<RS232_native>& transferDevice) {
+    // once the previous batch is written completely, collect all queued messages into the next one
+    // a broadcast message that is partially written to the device has to be finished first
+    if (writeOffset >= writeBatch.size()) {
+        if (broadcastStarted(currentDevice)) {
+            return;
+        }
+
+        // with a transmit capacity the batch is limited to it, the messages after it can still be dropped as a whole
+        writeBatch.clear();
+        writeOffset = 0;
+        transmitQueue.drainInto(writeBatch, transmitCapacity > 0 ? transmitCapacity : SIZE_MAX);
+    }
+
+    if (writeOffset >= writeBatch.size()) {
+        return;
+    }
+
+    // only write what the device takes without blocking, the rest is written the next time the device is writable.
+    // This way a large message never stops the reception of data.
+    auto remaining = static_cast<int>(std::min<size_t>(writeBatch.size() - writeOffset, INT_MAX));
+    auto written   = transferDevice->writeRawData(writeBatch.data() + writeOffset, remaining);
+    if (written > 0) {
+        writeOffset += static_cast<size_t>(written);
+        releaseTransmitSpace(static_cast<size_t>(written));
+    }
+}
+
+void sakurajin::RS232::prepareBroadcastWait(std::vector<size_t>& indices, std::vector<ioWaitEntry>& entries) {
+    if (pendingBroadcasts == 0) {
+        return;
+    }
+
+    std::scoped_lock lock{broadcastMutex};
+    for (size_t i = 0; i < broadcastJobs.size(); i++) {
+        if (broadcastJobs[i].empty()) {
+            continue;
+        }
+
+        // the messages of a device that was lost can never be written
+        if (rs232Devices[i]->getConnectionStatus() != sakurajin::connectionStatus::connected) {
+            failBroadcasts(i);
+            continue;
+        }
+
+        // a device that is probed by a connection attempt is only written to once the probe finished
+        if (connectInFlight(i)) {
+            continue;
+        }
+
+        entries.push_back(ioWaitEntry{rs232Devices[i].get(), ioWritable});
+        indices.push_back(i);
+    }
+}
+
+void sakurajin::RS232::handleBroadcastEvents(const size_t* indices, const ioWaitEntry* entries, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if ((entries[i].returned & ioError) != 0) {
+            std::scoped_lock lock{broadcastMutex};
+            failBroadcasts(indices[i]);
+            continue;
+        }
+
+        if ((entries[i].returned & ioWritable) != 0) {
+            writeBroadcasts(indices[i]);
+        }
+    }
+}
+
+void sakurajin::RS232::writeBroadcasts(size_t index) {
+    std::scoped_lock lock{broadcastMutex};
+
+    auto& jobs   = broadcastJobs[index];
+    auto& device = rs232Devices[index];
+    while (!jobs.empty()) {
+        auto& job = jobs.front();
+
+        // a batch of the transmit queue that is partially written to the same device has to be finished first
+        if (job.offset == 0 && index == currentDevice && writeOffset < writeBatch.size()) {
+            return;
+        }
+
+        auto remaining = static_cast<int>(std::min<size_t>(job.data->size() - job.offset, INT_MAX));
+        auto written   = device->writeRawData(job.data->data() + job.offset, remaining);
+        if (written < 0) {
+            failBroadcasts(index);
+            return;
+        }
+
+        // the rest is written the next time the device is writable
+        job.offset += static_cast<size_t>(written);
+        if (job.offset < job.data->size()) {
+            return;
+        }
+
+        job.completion.set_value(true);
+        jobs.pop_front();
+        pendingBroadcasts--;
+    }
+}
+
+void sakurajin::RS232::failBroadcasts(size_t index) {
+    auto& jobs = broadcastJobs[index];
+    for (auto& job : jobs) {
+        job.completion.set_value(false);
+    }
+    pendingBroadcasts -= jobs.size();
+    jobs.clear();
+}
+
+bool sakurajin::RS232::broadcastStarted(size_t index) {
+    if (pendingBroadcasts == 0) {
+        return false;
+    }
+
+    std::scoped_lock lock{broadcastMutex};
+    return index < broadcastJobs.size() && !broadcastJobs[index].empty() && broadcastJobs[index].front().offset > 0;
+}
+
+void sakurajin::RS232::tryReconnect() {
+    if (!autoReconnect) {
+        return;
+    }
+
+    // if DisconnectAll was called while an attempt was running, the devices it opened must not stay open
+    if (!reconnectPending) {
+        auto attempt = std::move(reconnectAttempt);
+        if (attempt != nullptr) {
+            std::scoped_lock lock{attempt->mutex};
+            attempt->abandonRunning();
+            for (size_t i = 0; i < rs232Devices.size(); i++) {
+                if (attempt->started[i] && attempt->results[i] == connectAttempt::accepted) {
+                    rs232Devices[i]->disconnect();
+                }
+            }
+        }
+        return;
+    }
+
+    // this runs on the I/O path (with a reactor even while the reactor is locked), so it must never wait for anything.
+    // If Connect is called at the same time, the attempt is simply made during a later call.
+    std::unique_lock connectLock{connectMutex, std::try_to_lock};
+    if (!connectLock.owns_lock()) {
+        return;
+    }
+
+    // a running attempt is only evaluated once all of its devices are done or its timeout expired
+    if (reconnectAttempt != nullptr) {
+        {
+            std::scoped_lock lock{reconnectAttempt->mutex};
+            if (!reconnectAttempt->allFinished() && std::chrono::steady_clock::now() < reconnectAttempt->deadline) {
+                return;
+            }
+        }
+
+        auto attempt = std::move(reconnectAttempt);
+        if (finishConnectAttempt(attempt)) {
+            // in fan in mode the attempts continue until all devices are connected again
+            reconnectPending = fanIn && anyDeviceDisconnected();
+
+            // the write stage might run on another thread that has to start waiting for the new device
+            workerWakeup->notify();
+        }
+        return;
+    }
+
+    // Connect might have been called in the meantime
+    if (!fanIn && getCurrentDevice()->getConnectionStatus() == sakurajin::connectionStatus::connected && !connectInFlight(currentDevice)) {
+        reconnectPending = false;
+        return;
+    }
+
+    // without a hot plug monitor the devices are checked periodically instead
+    auto now     = std::chrono::steady_clock::now();
+    bool changed = devicesChanged.exchange(false);
+    if (!changed && (hotplugMonitor != nullptr || now - lastReconnectAttempt < 500ms)) {
+        return;
+    }
+    lastReconnectAttempt = now;
+
+    // the devices are opened and probed in the background, the result is picked up by one of the next calls
+    reconnectAttempt = startConnectAttempt();
+}
+
+bool sakurajin::RS232::anyDeviceDisconnected() const {
+    return std::any_of(rs232Devices.begin(), rs232Devices.end(), [](const auto& device) {
+        return device->getConnectionStatus() != sakurajin::connectionStatus::connected;
+    });
+}
+
+bool sakurajin::RS232::connectInFlight(size_t index) const noexcept {
+    return connectsInFlight != nullptr && index < connectsInFlight->size() && (*connectsInFlight)[index];
+}
+
+void sakurajin::RS232::trimTransmitData() {
+    if (transmitCapacity == 0 || transmitPolicy != dropOldest) {
         return;
     }
 
-    auto transferDevice = getCurrentDevice();
-    if (transferDevice->getConnectionStatus() != sakurajin::connectionStatus::connected) {
-        // it is more likely that a device will be connected than that a device will be added
-        // because of this the sleep duration is lower
-        std::this_thread::sleep_for(1ms);
+    auto pending = transmitPending.load();
+    if (pending <= transmitCapacity) {
         return;
     }
 
-    // if there is something to write to the device, write it
-    if (writeBufferHasData) {
-        // lock the mutex to prevent the buffer from being changed while it is being moved
-        // try lock is not used here because the buffer is only locked for a short time
-        // both the print function and the work function only do a copy/move operation
-        writeBufferMutex.lock();
-        auto localWriteBuffer = std::move(writeBuffer);
-        writeBufferHasData    = false;
-        writeBufferMutex.unlock();
+    // only whole messages that were not started yet are dropped and the batch that is being written is always finished,
+    // so the device never sends the head of one message joined to the tail of another
+    auto dropped = transmitQueue.dropOldest(pending - transmitCapacity);
+    droppedTransmitBytes += dropped;
+    releaseTransmitSpace(dropped);
+}
+
+bool sakurajin::RS232::reserveTransmitSpace(size_t length) {
+    auto pending = transmitPending.load();
+    while (true) {
+        // a message larger than the capacity would never fit, so blocking calls take it once nothing else is pending
+        bool fits = transmitCapacity == 0 || transmitPolicy == dropOldest || pending + length <= transmitCapacity ||
+                    (pending == 0 && transmitPolicy == blockOnOverflow);
+        if (!fits) {
+            return false;
+        }
 
-        // write the data
-        auto err = native::Print(transferDevice, localWriteBuffer);
-        if (err < 0) {
-            std::cerr << "Error while writing to the device: " << err << std::endl;
+        if (transmitPending.compare_exchange_weak(pending, pending + length)) {
+            return true;
         }
     }
+}
+
+void sakurajin::RS232::releaseTransmitSpace(size_t length) {
+    transmitPending -= length;
 
-    // the read is a bit more complicated because the retrieve functions might block the code for a long time
-    // because of this the read is performed every call to work but first stored into a local static buffer.
-    static std::string queuedBuffer{};
-    char               IOBuf = '\0';
-    if (transferDevice->readRawData(&IOBuf, 1) > 0) {
+    // the mutex is locked once, so a Print call cannot miss the notification between checking for space and waiting
+    if (transmitWaiters > 0) {
+        {
+            std::scoped_lock lock{transmitSpaceMutex};
+        }
+        transmitSpaceCondition.notify_all();
+    }
+}
+
+void sakurajin::RS232::handleRead(const std::shared_ptr<RS232_native>& transferDevice, int returned) {
+    if ((returned & ioReadable) == 0 && queuedBuffer.empty() && pendingFrames.empty()) {
+        return;
+    }
+
+    // read everything the device has queued (up to the chunk size) with a single call
+    // the chunk buffer is reused and only resized if the chunk size was changed
+    int64_t readLength = 0;
+    if ((returned & ioReadable) != 0) {
+        auto chunkSize = std::clamp<size_t>(readChunkSize, 1, INT_MAX);
+        if (readChunk.size() != chunkSize) {
+            readChunk.resize(chunkSize);
+        }
+
+        readLength = transferDevice->readRawData(readChunk.data(), static_cast<int>(chunkSize));
+        readLength = std::max<int64_t>(readLength, 0);
+    }
+
+    // the flag is set before storing, so space that is freed while this thread stores the data still wakes it up
+    receiveSpaceWanted = true;
+    publishReadData(readChunk.data(), static_cast<size_t>(readLength));
+    receiveSpaceWanted = !queuedBuffer.empty() || !pendingFrames.empty();
+}
+
+void sakurajin::RS232::publishReadData(const char* data, size_t length) {
+    // with a frame decoder only the decoded frames are stored
+    // they are collected locally and moved over whenever the mutex is not used by the consumer
+    if (frameDecoder != nullptr) {
+        frameDecoder->decode(data, length, pendingFrames);
+        if (pendingFrames.empty() || !decodedFramesMutex.try_lock()) {
+            return;
+        }
+
+        storeDecodedFrames();
+        decodedFramesMutex.unlock();
+        return;
+    }
+
+    // the ring is lock free so the data can always be pushed directly
+    // whatever does not fit is queued until the consumer made room for it or dropped depending on the policy
+    if (receiveRing != nullptr) {
+        if (!queuedBuffer.empty()) {
+            auto pushed = receiveRing->push(queuedBuffer.data(), queuedBuffer.size());
+            queuedBuffer.erase(0, pushed);
+        }
+
+        size_t pushed = 0;
         if (queuedBuffer.empty()) {
-            queuedBuffer = std::string(1, IOBuf);
+            pushed = receiveRing->push(data, length);
+        }
+
+        if (receivePolicy == blockOnOverflow) {
+            queuedBuffer.append(data + pushed, length - pushed);
         } else {
-            queuedBuffer.append(1, IOBuf);
+            droppedReceiveBytes += length - pushed;
         }
+        return;
     }
 
-    // if there is data in the local buffer try locking the readBuffer mutex and add the data to the buffer
-    // if it takes too long to lock the mutex, try again during the next call to work
-    // this prevents long blocking of actual write operations while making sure no read data is lost.
-    if (!queuedBuffer.empty() && readBufferMutex.try_lock_for(1ms)) {
-        // if there is data, add it to the buffer
-        if (readBufferHasData) {
-            readBuffer.append(queuedBuffer);
-            queuedBuffer.clear();
-        } else {
-            // if there is no data, create a new buffer
-            readBuffer = std::move(queuedBuffer);
-            readBuffer.reserve(10);
-            readBufferHasData = true;
+    // the rope only locks its mutex for a short update, so the data can be appended directly as well
+    if (receiveRope != nullptr) {
+        if (!queuedBuffer.empty()) {
+            auto stored = storeInRope(queuedBuffer.data(), queuedBuffer.size());
+            queuedBuffer.erase(0, stored);
+        }
+
+        size_t stored = 0;
+        if (queuedBuffer.empty()) {
+            stored = storeInRope(data, length);
         }
+        queuedBuffer.append(data + stored, length - stored);
+        return;
+    }
 
-        readBufferMutex.unlock();
+    // the read is a bit more complicated because the retrieve functions might block the code for a long time.
+    // Try locking the readBuffer mutex and add the whole chunk (and previously queued data) to the buffer at once.
+    // If it takes too long to lock the mutex, queue the data and try again during the next call to work.
+    // This prevents long blocking of actual write operations while making sure no read data is lost.
+    if (!readBufferMutex.try_lock_for(1ms)) {
+        queuedBuffer.append(data, length);
+        return;
+    }
+
+    // the buffer content is invalid if it was moved out by retrieveReadBuffer
+    if (!readBufferHasData) {
+        readBuffer.clear();
     }
+
+    // the queued data is older than the new chunk, so it has to be stored first
+    // whatever is not stored because the buffer is full stays queued
+    if (queuedBuffer.empty()) {
+        auto stored = storeReceivedData(data, length);
+        queuedBuffer.assign(data + stored, length - stored);
+    } else {
+        queuedBuffer.append(data, length);
+        auto stored = storeReceivedData(queuedBuffer.data(), queuedBuffer.size());
+        queuedBuffer.erase(0, stored);
+    }
+    readBufferHasData = !readBuffer.empty();
+
+    readBufferMutex.unlock();
+}
+
+size_t sakurajin::RS232::storeReceivedData(const char* data, size_t length) {
+    if (receiveCapacity == 0) {
+        readBuffer.append(data, length);
+        return length;
+    }
+
+    // only keep the newest bytes that fit
+    if (receivePolicy == dropOldest) {
+        if (length >= receiveCapacity) {
+            droppedReceiveBytes += readBuffer.size() + length - receiveCapacity;
+            readBuffer.assign(data + length - receiveCapacity, receiveCapacity);
+            matchCursor = 0;
+            return length;
+        }
+
+        auto total = readBuffer.size() + length;
+        if (total > receiveCapacity) {
+            droppedReceiveBytes += total - receiveCapacity;
+            readBuffer.erase(0, total - receiveCapacity);
+            matchCursor = 0;
+        }
+        readBuffer.append(data, length);
+        return length;
+    }
+
+    auto space  = receiveCapacity - std::min(receiveCapacity, readBuffer.size());
+    auto stored = std::min(space, length);
+    readBuffer.append(data, stored);
+
+    // with the blocking policy the rest is stored once the consumer made room for it
+    if (receivePolicy == blockOnOverflow) {
+        return stored;
+    }
+
+    droppedReceiveBytes += length - stored;
+    return length;
+}
+
+size_t sakurajin::RS232::storeInRope(const char* data, size_t length) {
+    if (receiveCapacity == 0) {
+        receiveRope->append(data, length);
+        return length;
+    }
+
+    // only keep the newest bytes that fit, the old chunks are released instead of being moved
+    if (receivePolicy == dropOldest) {
+        auto stored = std::min(length, receiveCapacity);
+        auto total  = receiveRope->size() + stored;
+        if (total > receiveCapacity) {
+            droppedReceiveBytes += receiveRope->consume(total - receiveCapacity);
+        }
+        droppedReceiveBytes += length - stored;
+        receiveRope->append(data + length - stored, stored);
+        return length;
+    }
+
+    auto space  = receiveCapacity - std::min(receiveCapacity, receiveRope->size());
+    auto stored = std::min(space, length);
+    receiveRope->append(data, stored);
+
+    // with the blocking policy the rest is stored once the consumer made room for it
+    if (receivePolicy == blockOnOverflow) {
+        return stored;
+    }
+
+    droppedReceiveBytes += length - stored;
+    return length;
+}
+
+void sakurajin::RS232::storeDecodedFrames() {
+    storeBoundedEntries(decodedFrames,
+                        decodedFramesSize,
+                        pendingFrames,
+                        receiveCapacity,
+                        receivePolicy,
+                        droppedReceiveBytes,
+                        [](const std::string& frame) { return frame.size(); });
+}
+
+void sakurajin::RS232::publishChunks() {
+    if (pendingChunks.empty() || !receivedChunksMutex.try_lock()) {
+        return;
+    }
+
+    storeBoundedEntries(receivedChunks,
+                        receivedChunksSize,
+                        pendingChunks,
+                        receiveCapacity,
+                        receivePolicy,
+                        droppedReceiveBytes,
+                        [](const RS232_chunk& chunk) { return chunk.data.size(); });
+    receivedChunksMutex.unlock();
 }
 
 // io functions
-void sakurajin::RS232::Print(std::string text) {
-    std::scoped_lock lock(writeBufferMutex);
+bool sakurajin::RS232::acquireTransmitSpace(size_t length) {
+    if (reserveTransmitSpace(length)) {
+        return true;
+    }
 
-    if (writeBufferHasData) {
-        writeBuffer.append(text);
-    } else {
-        writeBuffer        = std::move(text);
-        writeBufferHasData = true;
+    switch (transmitPolicy) {
+        case dropNewest:
+            droppedTransmitBytes += length;
+            return false;
+        case failOnOverflow:
+            failedPrints++;
+            return false;
+        default:
+            break;
     }
+
+    // wait until the work thread wrote enough data or the object is destroyed
+    std::unique_lock lock{transmitSpaceMutex};
+    transmitWaiters++;
+    transmitSpaceCondition.wait(lock, [this, length]() { return stopThread || reserveTransmitSpace(length); });
+    transmitWaiters--;
+
+    return !stopThread;
+}
+
+bool sakurajin::RS232::Print(std::string text) {
+    if (!acquireTransmitSpace(text.size())) {
+        return false;
+    }
+
+    transmitQueue.push(std::move(text));
+
+    // wake up the work thread so it starts waiting for the device to become writable
+    workerWakeup->notify();
+    return true;
+}
+
+bool sakurajin::RS232::Print(std::string_view text) {
+    return PrintSegments(&text, 1);
+}
+
+bool sakurajin::RS232::Print(const char* text) {
+    return Print(std::string_view{text});
+}
+
+bool sakurajin::RS232::PrintSegments(const std::string_view* segments, size_t count) {
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        length += segments[i].size();
+    }
+
+    if (!acquireTransmitSpace(length)) {
+        return false;
+    }
+
+    transmitQueue.pushSegments(segments, count);
+
+    // wake up the work thread so it starts waiting for the device to become writable
+    workerWakeup->notify();
+    return true;
+}
+
+bool sakurajin::RS232::PrintSegments(std::initializer_list<std::string_view> segments) {
+    return PrintSegments(segments.begin(), segments.size());
+}
+
+std::vector<std::future<bool>> sakurajin::RS232::Broadcast(std::shared_ptr<const std::string> data,
+                                                            const std::vector<size_t>&         deviceIndices) {
+    std::vector<std::future<bool>> results;
+    results.reserve(deviceIndices.size());
+
+    {
+        std::scoped_lock lock{broadcastMutex};
+        for (auto index : deviceIndices) {
+            std::promise<bool> completion;
+            results.push_back(completion.get_future());
+
+            if (data == nullptr || index >= rs232Devices.size() ||
+                rs232Devices[index]->getConnectionStatus() != sakurajin::connectionStatus::connected) {
+                completion.set_value(false);
+                continue;
+            }
+
+            if (data->empty()) {
+                completion.set_value(true);
+                continue;
+            }
+
+            broadcastJobs[index].push_back(broadcastJob{data, 0, std::move(completion)});
+            pendingBroadcasts++;
+        }
+    }
+
+    workerWakeup->notify();
+    return results;
+}
+
+std::vector<std::future<bool>> sakurajin::RS232::Broadcast(std::shared_ptr<const std::string> data) {
+    std::vector<size_t> deviceIndices(rs232Devices.size());
+    for (size_t i = 0; i < deviceIndices.size(); i++) {
+        deviceIndices[i] = i;
+    }
+    return Broadcast(std::move(data), deviceIndices);
+}
+
+sakurajin::RS232_bufferStats sakurajin::RS232::getBufferStats() const {
+    RS232_bufferStats stats;
+    stats.droppedReceiveBytes  = droppedReceiveBytes;
+    stats.droppedTransmitBytes = droppedTransmitBytes;
+    stats.failedPrints         = failedPrints;
+    stats.pendingTransmitBytes = transmitPending;
+    return stats;
 }
 
 std::string sakurajin::RS232::retrieveReadBuffer() {
+    receiveSpaceGuard spaceGuard{*this};
+
+    if (receiveRing != nullptr) {
+        std::string content(receiveRing->size(), '\0');
+        content.resize(receiveRing->pop(content.data(), content.size()));
+        return content;
+    }
+
+    if (receiveRope != nullptr) {
+        std::string content(receiveRope->size(), '\0');
+        content.resize(receiveRope->pop(content.data(), content.size()));
+        return content;
+    }
+
     if (!readBufferHasData) {
         return std::string{};
     }
@@ -178,47 +1321,254 @@ std::string sakurajin::RS232::retrieveReadBuffer() {
     std::scoped_lock lock(readBufferMutex);
 
     readBufferHasData = false;
+    matchCursor       = 0;
     return std::move(readBuffer);
 }
 
+size_t sakurajin::RS232::retrieveFromRing(char* destination, size_t length) {
+    receiveSpaceGuard spaceGuard{*this};
+
+    if (receiveRing == nullptr || destination == nullptr) {
+        return 0;
+    }
+
+    return receiveRing->pop(destination, length);
+}
+
+size_t sakurajin::RS232::retrieveInto(char* destination, size_t length) {
+    receiveSpaceGuard spaceGuard{*this};
+
+    if (destination == nullptr || length == 0) {
+        return 0;
+    }
+
+    if (receiveRing != nullptr) {
+        return receiveRing->pop(destination, length);
+    }
+
+    if (receiveRope != nullptr) {
+        return receiveRope->pop(destination, length);
+    }
+
+    if (!readBufferHasData) {
+        return 0;
+    }
+
+    std::scoped_lock lock(readBufferMutex);
+
+    auto copied = std::min(length, readBuffer.size());
+    std::memcpy(destination, readBuffer.data(), copied);
+    readBuffer.erase(0, copied);
+
+    readBufferHasData = !readBuffer.empty();
+    matchCursor       = 0;
+    return copied;
+}
+
+size_t sakurajin::RS232::swapReadBuffer(std::string& buffer) {
+    buffer.clear();
+
+    receiveSpaceGuard spaceGuard{*this};
+
+    if (receiveRing != nullptr) {
+        buffer.resize(receiveRing->size());
+        buffer.resize(receiveRing->pop(buffer.data(), buffer.size()));
+        return buffer.size();
+    }
+
+    if (receiveRope != nullptr) {
+        buffer.resize(receiveRope->size());
+        buffer.resize(receiveRope->pop(buffer.data(), buffer.size()));
+        return buffer.size();
+    }
+
+    if (!readBufferHasData) {
+        return 0;
+    }
+
+    std::scoped_lock lock(readBufferMutex);
+
+    // the empty buffer of the caller becomes the new read buffer, so both strings keep their capacity
+    std::swap(buffer, readBuffer);
+    readBufferHasData = false;
+    matchCursor       = 0;
+    return buffer.size();
+}
+
+sakurajin::RS232_ropeView sakurajin::RS232::peek(size_t maxLength) const {
+    if (receiveRope == nullptr) {
+        return RS232_ropeView{};
+    }
+
+    return receiveRope->peek(maxLength);
+}
+
+size_t sakurajin::RS232::consume(size_t length) {
+    receiveSpaceGuard spaceGuard{*this};
+
+    if (receiveRope == nullptr) {
+        return 0;
+    }
+
+    return receiveRope->consume(length);
+}
+
 std::string sakurajin::RS232::retrieveFirstMatch(const std::regex& pattern) {
     if (!readBufferHasData) {
         return std::string{};
     }
 
-    std::scoped_lock lock(readBufferMutex);
-    std::smatch      s_match_result;
+    receiveSpaceGuard spaceGuard{*this};
+    std::scoped_lock  lock(readBufferMutex);
+    std::smatch       s_match_result;
     std::regex_search(readBuffer, s_match_result, pattern);
     if (s_match_result.empty()) {
         return std::string{};
     }
 
-    readBuffer = s_match_result.suffix();
-    return s_match_result.str();
+    // remove everything up to the end of the match in place instead of copying the suffix
+    auto match = s_match_result.str();
+    readBuffer.erase(0, static_cast<size_t>(s_match_result[0].second - readBuffer.cbegin()));
+    readBufferHasData = !readBuffer.empty();
+    matchCursor       = 0;
+    return match;
 }
 
 std::vector<std::string> sakurajin::RS232::retrieveAllMatches(const std::regex& pattern) {
+    return retrieveAllMatches(pattern, 0);
+}
+
+std::vector<std::string> sakurajin::RS232::retrieveAllMatches(const std::regex& pattern, size_t maxMatchLength) {
     if (!readBufferHasData) {
         return std::vector<std::string>{};
     }
 
-    std::scoped_lock lock(readBufferMutex);
+    receiveSpaceGuard spaceGuard{*this};
+    std::scoped_lock  lock(readBufferMutex);
 
-    std::string              searchString = readBuffer;
-    std::smatch              curr_match;
+    // without a known maximum match length every byte could still be the start of a match, so the whole buffer is searched
+    size_t searchStart = maxMatchLength > 0 ? std::min(matchCursor, readBuffer.size()) : 0;
+    auto   flags       = searchStart > 0 ? std::regex_constants::match_prev_avail : std::regex_constants::match_default;
+
+    // iterate over the matches in place, the buffer is only modified once after all matches were found
     std::vector<std::string> matches{};
+    size_t                   consumed = 0;
+    for (std::sregex_iterator matchIT{readBuffer.cbegin() + searchStart, readBuffer.cend(), pattern, flags}, endIT; matchIT != endIT;
+         ++matchIT) {
+        matches.emplace_back(matchIT->str());
+        consumed = static_cast<size_t>((*matchIT)[0].second - readBuffer.cbegin());
+    }
+
+    // the erase shifts the buffer, so a cursor left behind by the bounded search would point past the unsearched bytes
+    if (consumed > 0) {
+        readBuffer.erase(0, consumed);
+        readBufferHasData = !readBuffer.empty();
+        matchCursor       = 0;
+    }
 
-    std::regex_search(searchString, curr_match, pattern);
-    while(!curr_match.empty()){
-        matches.emplace_back(curr_match.str());
-        searchString = curr_match.suffix();
-        std::regex_search(searchString, curr_match, pattern);
+    // A match that starts more than maxMatchLength bytes before the end would have been found already.
+    // These bytes can never be part of a match, so the next call starts searching after them.
+    if (maxMatchLength > 0) {
+        matchCursor = readBuffer.size() >= maxMatchLength ? readBuffer.size() - maxMatchLength + 1 : 0;
     }
 
-    readBuffer = searchString;
     return matches;
 }
 
+std::string sakurajin::RS232::retrieveUntil(std::string_view delimiters) {
+    if (!readBufferHasData || delimiters.empty()) {
+        return std::string{};
+    }
+
+    receiveSpaceGuard spaceGuard{*this};
+    std::scoped_lock  lock(readBufferMutex);
+
+    const char* begin     = readBuffer.data();
+    const char* delimiter = findDelimiter(begin, begin + readBuffer.size(), delimiters);
+    if (delimiter == begin + readBuffer.size()) {
+        return std::string{};
+    }
+
+    auto frameLength = static_cast<size_t>(delimiter - begin) + 1;
+    auto frame       = readBuffer.substr(0, frameLength);
+    readBuffer.erase(0, frameLength);
+    readBufferHasData = !readBuffer.empty();
+    matchCursor       = 0;
+    return frame;
+}
+
+std::vector<std::string> sakurajin::RS232::retrieveFrames(std::string_view delimiters, bool includeDelimiter) {
+    if (!readBufferHasData || delimiters.empty()) {
+        return std::vector<std::string>{};
+    }
+
+    receiveSpaceGuard spaceGuard{*this};
+    std::scoped_lock  lock(readBufferMutex);
+
+    std::vector<std::string> frames{};
+    const char*              frameStart = readBuffer.data();
+    const char*              end        = frameStart + readBuffer.size();
+    while (frameStart < end) {
+        auto delimiter = findDelimiter(frameStart, end, delimiters);
+        if (delimiter == end) {
+            break;
+        }
+
+        frames.emplace_back(frameStart, static_cast<size_t>(delimiter - frameStart) + (includeDelimiter ? 1 : 0));
+        frameStart = delimiter + 1;
+    }
+
+    // only the complete frames are removed, the partial frame at the end stays in the buffer
+    auto consumed = static_cast<size_t>(frameStart - readBuffer.data());
+    if (consumed > 0) {
+        readBuffer.erase(0, consumed);
+        readBufferHasData = !readBuffer.empty();
+        matchCursor       = 0;
+    }
+
+    return frames;
+}
+
+std::vector<std::string> sakurajin::RS232::retrieveDecodedFrames() {
+    receiveSpaceGuard spaceGuard{*this};
+    std::scoped_lock  lock(decodedFramesMutex);
+
+    std::vector<std::string> frames{};
+    std::swap(frames, decodedFrames);
+    decodedFramesSize = 0;
+    return frames;
+}
+
+size_t sakurajin::RS232::swapDecodedFrames(std::vector<std::string>& frames) {
+    frames.clear();
+
+    receiveSpaceGuard spaceGuard{*this};
+    std::scoped_lock  lock(decodedFramesMutex);
+    std::swap(frames, decodedFrames);
+    decodedFramesSize = 0;
+    return frames.size();
+}
+
+std::vector<sakurajin::RS232_chunk> sakurajin::RS232::retrieveChunks() {
+    receiveSpaceGuard spaceGuard{*this};
+    std::scoped_lock  lock(receivedChunksMutex);
+
+    std::vector<RS232_chunk> chunks{};
+    std::swap(chunks, receivedChunks);
+    receivedChunksSize = 0;
+    return chunks;
+}
+
+size_t sakurajin::RS232::swapChunks(std::vector<RS232_chunk>& chunks) {
+    chunks.clear();
+
+    receiveSpaceGuard spaceGuard{*this};
+    std::scoped_lock  lock(receivedChunksMutex);
+    std::swap(chunks, receivedChunks);
+    receivedChunksSize = 0;
+    return chunks.size();
+}
+
 // device access functions
 std::shared_ptr<sakurajin::RS232_native> sakurajin::RS232::getNativeDevice(size_t index) const {
     if (rs232Devices.empty()) {
@@ -234,13 +1584,21 @@ std::shared_ptr<sakurajin::RS232_native> sakurajin::RS232::getCurrentDevice() co
     return getNativeDevice(currentDevice);
 }
 bool sakurajin::RS232::IsAvailable() const {
-    return getCurrentDevice()->getConnectionStatus() == sakurajin::connectionStatus::connected;
+    return getCurrentDevice()->getConnectionStatus() == sakurajin::connectionStatus::connected && !connectInFlight(currentDevice);
 }
 
 size_t sakurajin::RS232::getDeviceCount() const {
     return rs232Devices.size();
 }
 
+void sakurajin::RS232::setReadChunkSize(size_t chunkSize) {
+    readChunkSize = std::max<size_t>(chunkSize, 1);
+}
+
+size_t sakurajin::RS232::getReadChunkSize() const {
+    return readChunkSize;
+}
+
 // deprecated functions
 void sakurajin::RS232::Close() {
     DisconnectAll();
@@ -265,5 +1623,5 @@ bool sakurajin::RS232::IsAvailable(size_t index) const {
         return false;
     }
 
-    return dev->getConnectionStatus() == sakurajin::connectionStatus::connected;
+    return dev->getConnectionStatus() == sakurajin::connectionStatus::connected && !connectInFlight(index);
 }
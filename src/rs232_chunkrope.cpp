@@ -0,0 +1,179 @@
+#include "rs232_chunkrope.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// view functions
+size_t sakurajin::RS232_ropeView::size() const noexcept {
+    return totalSize;
+}
+
+bool sakurajin::RS232_ropeView::empty() const noexcept {
+    return totalSize == 0;
+}
+
+const std::vector<std::string_view>& sakurajin::RS232_ropeView::getSegments() const noexcept {
+    return segments;
+}
+
+char sakurajin::RS232_ropeView::at(size_t index) const {
+    for (const auto& segment : segments) {
+        if (index < segment.size()) {
+            return segment[index];
+        }
+        index -= segment.size();
+    }
+
+    throw std::out_of_range("the index is outside of the rope view");
+}
+
+size_t sakurajin::RS232_ropeView::findFirstOf(std::string_view characters, size_t start) const noexcept {
+    size_t segmentStart = 0;
+    for (const auto& segment : segments) {
+        if (start < segmentStart + segment.size()) {
+            auto position = segment.find_first_of(characters, start > segmentStart ? start - segmentStart : 0);
+            if (position != std::string_view::npos) {
+                return segmentStart + position;
+            }
+        }
+        segmentStart += segment.size();
+    }
+
+    return npos;
+}
+
+size_t sakurajin::RS232_ropeView::copyTo(char* destination, size_t length, size_t offset) const noexcept {
+    if (destination == nullptr) {
+        return 0;
+    }
+
+    size_t copied = 0;
+    for (const auto& segment : segments) {
+        if (copied == length) {
+            break;
+        }
+
+        // skip the segments that are completely before the offset
+        if (offset >= segment.size()) {
+            offset -= segment.size();
+            continue;
+        }
+
+        auto part = std::min(segment.size() - offset, length - copied);
+        std::memcpy(destination + copied, segment.data() + offset, part);
+        copied += part;
+        offset  = 0;
+    }
+
+    return copied;
+}
+
+std::string sakurajin::RS232_ropeView::copy(size_t offset, size_t length) const {
+    if (offset >= totalSize) {
+        return std::string{};
+    }
+
+    std::string content(std::min(length, totalSize - offset), '\0');
+    copyTo(content.data(), content.size(), offset);
+    return content;
+}
+
+// rope functions
+size_t sakurajin::RS232_chunkRope::size() const {
+    std::scoped_lock lock{ropeMutex};
+    return totalSize;
+}
+
+bool sakurajin::RS232_chunkRope::empty() const {
+    return size() == 0;
+}
+
+void sakurajin::RS232_chunkRope::append(const char* data, size_t length) {
+    if (data == nullptr || length == 0) {
+        return;
+    }
+
+    // the chunk is allocated before locking, so the consumer is never blocked by the allocation
+    append(std::make_shared<const std::string>(data, length));
+}
+
+void sakurajin::RS232_chunkRope::append(std::shared_ptr<const std::string> chunk) {
+    if (chunk == nullptr || chunk->empty()) {
+        return;
+    }
+
+    std::scoped_lock lock{ropeMutex};
+    totalSize += chunk->size();
+    chunks.push_back(std::move(chunk));
+}
+
+sakurajin::RS232_ropeView sakurajin::RS232_chunkRope::peek(size_t maxLength) const {
+    RS232_ropeView view;
+
+    std::scoped_lock lock{ropeMutex};
+
+    auto offset = frontOffset;
+    for (const auto& chunk : chunks) {
+        if (view.totalSize == maxLength) {
+            break;
+        }
+
+        auto part = std::min(chunk->size() - offset, maxLength - view.totalSize);
+        view.chunks.push_back(chunk);
+        view.segments.emplace_back(chunk->data() + offset, part);
+        view.totalSize += part;
+        offset          = 0;
+    }
+
+    return view;
+}
+
+size_t sakurajin::RS232_chunkRope::consumeLocked(size_t length) noexcept {
+    length = std::min(length, totalSize);
+    totalSize -= length;
+
+    // whole chunks are released, the rest only advances the offset into the first chunk
+    auto remaining = length;
+    while (remaining > 0) {
+        auto available = chunks.front()->size() - frontOffset;
+        if (remaining < available) {
+            frontOffset += remaining;
+            break;
+        }
+
+        remaining -= available;
+        frontOffset = 0;
+        chunks.pop_front();
+    }
+
+    return length;
+}
+
+size_t sakurajin::RS232_chunkRope::consume(size_t length) {
+    std::scoped_lock lock{ropeMutex};
+    return consumeLocked(length);
+}
+
+size_t sakurajin::RS232_chunkRope::pop(char* destination, size_t length) {
+    if (destination == nullptr) {
+        return 0;
+    }
+
+    std::scoped_lock lock{ropeMutex};
+
+    size_t copied = 0;
+    auto   offset = frontOffset;
+    for (const auto& chunk : chunks) {
+        if (copied == length) {
+            break;
+        }
+
+        auto part = std::min(chunk->size() - offset, length - copied);
+        std::memcpy(destination + copied, chunk->data() + offset, part);
+        copied += part;
+        offset  = 0;
+    }
+
+    return consumeLocked(copied);
+}
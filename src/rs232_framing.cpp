@@ -0,0 +1,145 @@
+#include "rs232_framing.hpp"
+
+#include <algorithm>
+
+// COBS
+sakurajin::RS232_cobsDecoder::RS232_cobsDecoder(size_t _maxFrameLength)
+    : maxFrameLength(_maxFrameLength) {}
+
+void sakurajin::RS232_cobsDecoder::decode(const char* data, size_t length, std::vector<std::string>& frames) {
+    for (size_t i = 0; i < length; i++) {
+        auto byte = static_cast<uint8_t>(data[i]);
+
+        // a zero always ends the frame, it is only valid if the last block is complete
+        if (byte == 0) {
+            if (!invalidFrame && remainingBlock == 0 && !currentFrame.empty()) {
+                frames.emplace_back(std::move(currentFrame));
+            }
+            reset();
+            continue;
+        }
+
+        if (invalidFrame) {
+            continue;
+        }
+
+        if (remainingBlock == 0) {
+            // this is a code byte, the zero of the previous block is only added once it is clear the frame continues
+            if (pendingZero) {
+                currentFrame.push_back('\0');
+            }
+            remainingBlock = byte - 1;
+            pendingZero    = byte != 0xFF;
+        } else {
+            currentFrame.push_back(static_cast<char>(byte));
+            remainingBlock--;
+        }
+
+        if (currentFrame.size() > maxFrameLength) {
+            invalidFrame = true;
+        }
+    }
+}
+
+void sakurajin::RS232_cobsDecoder::reset() noexcept {
+    currentFrame.clear();
+    remainingBlock = 0;
+    pendingZero    = false;
+    invalidFrame   = false;
+}
+
+// SLIP
+namespace {
+    constexpr char slipEnd        = static_cast<char>(0xC0);
+    constexpr char slipEscape     = static_cast<char>(0xDB);
+    constexpr char slipEscapedEnd = static_cast<char>(0xDC);
+    constexpr char slipEscapedEsc = static_cast<char>(0xDD);
+} // namespace
+
+sakurajin::RS232_slipDecoder::RS232_slipDecoder(size_t _maxFrameLength)
+    : maxFrameLength(_maxFrameLength) {}
+
+void sakurajin::RS232_slipDecoder::decode(const char* data, size_t length, std::vector<std::string>& frames) {
+    for (size_t i = 0; i < length; i++) {
+        auto byte = data[i];
+
+        if (byte == slipEnd) {
+            if (!invalidFrame && !currentFrame.empty()) {
+                frames.emplace_back(std::move(currentFrame));
+            }
+            reset();
+            continue;
+        }
+
+        if (escaped) {
+            // RFC 1055 says to keep the byte if it is not a valid escape sequence
+            escaped = false;
+            if (byte == slipEscapedEnd) {
+                byte = slipEnd;
+            } else if (byte == slipEscapedEsc) {
+                byte = slipEscape;
+            }
+        } else if (byte == slipEscape) {
+            escaped = true;
+            continue;
+        }
+
+        if (invalidFrame) {
+            continue;
+        }
+
+        currentFrame.push_back(byte);
+        if (currentFrame.size() > maxFrameLength) {
+            invalidFrame = true;
+        }
+    }
+}
+
+void sakurajin::RS232_slipDecoder::reset() noexcept {
+    currentFrame.clear();
+    escaped      = false;
+    invalidFrame = false;
+}
+
+// length prefix
+sakurajin::RS232_lengthPrefixDecoder::RS232_lengthPrefixDecoder(bool isBigEndian)
+    : bigEndian(isBigEndian) {}
+
+void sakurajin::RS232_lengthPrefixDecoder::decode(const char* data, size_t length, std::vector<std::string>& frames) {
+    size_t i = 0;
+    while (i < length) {
+        // collect the two header bytes
+        if (headerBytes < 2) {
+            auto byte = static_cast<uint8_t>(data[i++]);
+            if ((headerBytes == 0) == bigEndian) {
+                payloadLength |= static_cast<uint16_t>(byte << 8U);
+            } else {
+                payloadLength |= byte;
+            }
+            headerBytes++;
+
+            if (headerBytes == 2) {
+                currentFrame.reserve(payloadLength);
+            }
+        }
+
+        // copy as much of the payload as possible at once
+        if (headerBytes == 2) {
+            auto missing = payloadLength - currentFrame.size();
+            auto count   = std::min(missing, length - i);
+            currentFrame.append(data + i, count);
+            i += count;
+
+            if (currentFrame.size() == payloadLength) {
+                frames.emplace_back(std::move(currentFrame));
+                reset();
+            }
+        }
+    }
+}
+
+void sakurajin::RS232_lengthPrefixDecoder::reset() noexcept {
+    currentFrame.clear();
+    headerBytes   = 0;
+    payloadLength = 0;
+}
@@ -0,0 +1,149 @@
+#include "rs232_hotplug.hpp"
+
+#ifdef __linux__
+    #include <poll.h>
+    #include <sys/eventfd.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+#ifdef __linux__
+namespace {
+    // index 0 is the inotify file descriptor, index 1 the eventfd that stops the thread
+    inline int* getMonitorFds(void* monitorHandle) noexcept {
+        return static_cast<int*>(monitorHandle);
+    }
+
+    // /dev/serial and its subdirectories only exist while a serial device is connected, so they are watched again on every change
+    // adding an existing watch again just updates it
+    // returns false if /dev itself cannot be watched
+    bool addWatches(int inotifyFd) noexcept {
+        constexpr uint32_t nodeEvents = IN_CREATE | IN_DELETE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO;
+
+        inotify_add_watch(inotifyFd, "/dev/serial", nodeEvents);
+        inotify_add_watch(inotifyFd, "/dev/serial/by-id", nodeEvents);
+        inotify_add_watch(inotifyFd, "/dev/serial/by-path", nodeEvents);
+        return inotify_add_watch(inotifyFd, "/dev", nodeEvents) >= 0;
+    }
+} // namespace
+
+sakurajin::RS232_hotplugMonitor::RS232_hotplugMonitor() {
+    auto fds = new int[2]{-1, -1};
+    fds[0]   = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    fds[1]   = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (fds[0] < 0 || fds[1] < 0 || !addWatches(fds[0])) {
+        for (int i = 0; i < 2; i++) {
+            if (fds[i] >= 0) {
+                close(fds[i]);
+            }
+        }
+        delete[] fds;
+        throw std::runtime_error("unable to monitor /dev for device changes");
+    }
+
+    monitorHandle = static_cast<void*>(fds);
+
+    thread = std::async(std::launch::async, [this]() { run(); });
+}
+
+sakurajin::RS232_hotplugMonitor::~RS232_hotplugMonitor() {
+    auto     fds   = getMonitorFds(monitorHandle);
+    uint64_t value = 1;
+    [[maybe_unused]] auto res = write(fds[1], &value, sizeof(value));
+
+    if (thread.valid()) {
+        thread.wait();
+    }
+
+    close(fds[0]);
+    close(fds[1]);
+    delete[] fds;
+}
+
+void sakurajin::RS232_hotplugMonitor::run() {
+    auto fds = getMonitorFds(monitorHandle);
+
+    // the events are only used as a trigger, so their content is read and discarded
+    alignas(inotify_event) char buffer[4096];
+
+    while (true) {
+        pollfd pollList[2] = {
+            {fds[0], POLLIN, 0},
+            {fds[1], POLLIN, 0}
+        };
+
+        if (poll(pollList, 2, -1) < 0) {
+            continue;
+        }
+
+        if ((pollList[1].revents & POLLIN) != 0) {
+            return;
+        }
+
+        // drain all events, a device that is plugged in usually creates many of them at once
+        bool changed = false;
+        while (read(fds[0], buffer, sizeof(buffer)) > 0) {
+            changed = true;
+        }
+
+        if (changed) {
+            addWatches(fds[0]);
+            notifySubscribers();
+        }
+    }
+}
+#else
+sakurajin::RS232_hotplugMonitor::RS232_hotplugMonitor() {
+    throw std::runtime_error("monitoring device changes is not supported on this platform");
+}
+
+sakurajin::RS232_hotplugMonitor::~RS232_hotplugMonitor() = default;
+
+void sakurajin::RS232_hotplugMonitor::run() {}
+#endif
+
+void sakurajin::RS232_hotplugMonitor::notifySubscribers() {
+    std::scoped_lock lock{subscriberMutex};
+    for (auto& entry : subscribers) {
+        *entry.changed = true;
+        if (entry.wakeup != nullptr) {
+            entry.wakeup->notify();
+        }
+    }
+}
+
+std::shared_ptr<sakurajin::RS232_hotplugMonitor> sakurajin::RS232_hotplugMonitor::getShared() noexcept {
+    static std::mutex                          instanceMutex;
+    static std::weak_ptr<RS232_hotplugMonitor> instance;
+
+    std::scoped_lock lock{instanceMutex};
+
+    auto monitor = instance.lock();
+    if (monitor != nullptr) {
+        return monitor;
+    }
+
+    try {
+        monitor  = std::make_shared<RS232_hotplugMonitor>();
+        instance = monitor;
+    } catch (...) {
+        return nullptr;
+    }
+    return monitor;
+}
+
+void sakurajin::RS232_hotplugMonitor::subscribe(std::atomic<bool>* changed, RS232_wakeup* wakeup) {
+    std::scoped_lock lock{subscriberMutex};
+    subscribers.push_back(subscriber{changed, wakeup});
+}
+
+void sakurajin::RS232_hotplugMonitor::unsubscribe(std::atomic<bool>* changed) {
+    std::scoped_lock lock{subscriberMutex};
+
+    auto subscriberIT =
+        std::find_if(subscribers.begin(), subscribers.end(), [changed](const subscriber& entry) { return entry.changed == changed; });
+    if (subscriberIT != subscribers.end()) {
+        subscribers.erase(subscriberIT);
+    }
+}
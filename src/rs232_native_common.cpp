@@ -1,24 +1,109 @@
-#include <array>
+#include <climits>
 #include <utility>
 
 #include "rs232_native.hpp"
+#include "rs232_portindex.hpp"
 
 using namespace std::literals;
 
-sakurajin::RS232_native::RS232_native(std::string deviceName, Baudrate _baudrate, std::ostream& error_stream)
-    : devname(std::move(deviceName)) {
-    baudrate   = _baudrate;
-    connStatus = connect(error_stream);
+sakurajin::RS232_native::RS232_native(std::string              deviceName,
+                                      Baudrate                 _baudrate,
+                                      std::ostream&            error_stream,
+                                      const lineConfiguration& config,
+                                      bool                     openPort)
+    : devname(std::move(deviceName)),
+      lineConfig(config) {
+    baudrate = _baudrate;
+    if (openPort) {
+        connStatus = connect(error_stream);
+    }
+}
+
+sakurajin::RS232_native::RS232_native(std::string              deviceName,
+                                      uint32_t                 bitsPerSecond,
+                                      std::ostream&            error_stream,
+                                      const lineConfiguration& config,
+                                      bool                     openPort)
+    : devname(std::move(deviceName)),
+      lineConfig(config) {
+    customBaudrate = bitsPerSecond;
+    if (openPort) {
+        connStatus = connect(error_stream);
+    }
 }
 
 sakurajin::RS232_native::~RS232_native() {
     disconnect();
 }
 
+void sakurajin::RS232_native::drainOutput() noexcept {
+    constexpr auto stallTimeout = 100ms;
+    constexpr auto totalTimeout = 2000ms;
+
+    auto    start        = std::chrono::steady_clock::now();
+    auto    lastProgress = start;
+    int64_t lowest       = INT64_MAX;
+    while (true) {
+        auto pending = pendingOutput();
+        if (pending <= 0) {
+            return;
+        }
+
+        // the queue only makes progress if it gets smaller than it ever was, new writes do not count
+        auto now = std::chrono::steady_clock::now();
+        if (pending < lowest) {
+            lowest       = pending;
+            lastProgress = now;
+        } else if (now - lastProgress > stallTimeout) {
+            return;
+        }
+        if (now - start > totalTimeout) {
+            return;
+        }
+
+        std::this_thread::sleep_for(1ms);
+    }
+}
+
 bool sakurajin::RS232_native::changeBaudrate(sakurajin::Baudrate Rate, std::ostream& error_stream) noexcept {
-    disconnect();
-    baudrate = Rate;
-    return connect(error_stream) == connectionStatus::connected;
+    return reconfigure(
+        [this, Rate]() {
+            baudrate       = Rate;
+            customBaudrate = 0;
+        },
+        error_stream);
+}
+
+bool sakurajin::RS232_native::changeBaudrate(uint32_t bitsPerSecond, std::ostream& error_stream) noexcept {
+    return reconfigure([this, bitsPerSecond]() { customBaudrate = bitsPerSecond; }, error_stream);
+}
+
+uint32_t sakurajin::RS232_native::getBaudrate() const noexcept {
+    return appliedBaudrate;
+}
+
+bool sakurajin::RS232_native::changeLineConfiguration(const lineConfiguration& config,
+                                                     std::ostream&            error_stream,
+                                                     bool                     connectIfClosed) noexcept {
+    return reconfigure([this, &config]() { lineConfig = config; }, error_stream, connectIfClosed);
+}
+
+sakurajin::lineConfiguration sakurajin::RS232_native::getLineConfiguration() noexcept {
+    std::shared_lock lock{dataAccessMutex};
+    return lineConfig;
+}
+
+bool sakurajin::RS232_native::setLowLatency(bool enable, uint8_t latencyTimer, std::ostream& error_stream) noexcept {
+    lowLatency      = enable;
+    lowLatencyTimer = latencyTimer;
+
+    // the settings are applied by connect if the port is not open yet
+    std::scoped_lock lock{dataAccessMutex};
+    if (portHandle == nullptr) {
+        return true;
+    }
+
+    return applyLatencySettings(error_stream);
 }
 
 sakurajin::connectionStatus sakurajin::RS232_native::getConnectionStatus() noexcept {
@@ -29,6 +114,32 @@ std::string_view sakurajin::RS232_native::getDeviceName() const noexcept {
     return devname;
 }
 
+int64_t sakurajin::RS232_native::readRawDataTimed(char* data_location, int length, std::chrono::milliseconds timeout) noexcept {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (true) {
+        // try reading first, if data is already available there is no need to wait
+        auto readLength = readRawData(data_location, length);
+        if (readLength > 0) {
+            return readLength;
+        }
+
+        if (connStatus != connectionStatus::connected) {
+            return -1;
+        }
+
+        auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (timeout.count() >= 0 && remaining.count() <= 0) {
+            return 0;
+        }
+
+        ioWaitEntry entry{this, ioReadable};
+        if (waitForEvents(&entry, 1, nullptr, timeout.count() < 0 ? timeout : remaining) < 0 || (entry.returned & ioError) != 0) {
+            return -1;
+        }
+    }
+}
+
 bool sakurajin::RS232_native::checkForFlag(sakurajin::portStatusFlags flag, bool block) noexcept {
     auto flags = retrieveFlags(block);
     if (flags < 0) {
@@ -38,41 +149,12 @@ bool sakurajin::RS232_native::checkForFlag(sakurajin::portStatusFlags flag, bool
 }
 
 std::vector<std::string> sakurajin::getAvailablePorts() noexcept {
-    std::vector<std::string> allPorts;
-
-    // All the regex patterns to check for available ports
-    // These are the patterns across every platform that I could find
-    // The filtering for the os is done in the getMatchingPorts function
-    using rgx = std::regex;
-    const std::array<std::regex, 7> patters{rgx("/dev/ttyUSB[0-9]+"),
-                                            rgx("/dev/ttyACM[0-9]+"),
-                                            rgx("\\./COM[0-9]+"),
-                                            rgx("/dev/cu\\.[a-zA-Z0-9]+"),
-                                            rgx("/dev/cuaU[0-9]+"),
-                                            rgx("/dev/tty.usbmodem[0-9]+"),
-                                            rgx("/dev/tty.usbserial[0-9]+")};
-
-    for (const auto& pattern : patters) {
-        // get all matches for the regex pattern and continue if there are none
-        auto matches = sakurajin::getMatchingPorts(pattern);
-        if (matches.empty()) {
-            continue;
-        }
-
-        // remove duplicates
-        for (const auto& port : allPorts) {
-            for (auto matchIT = matches.begin(); matchIT != matches.end(); matchIT++) {
-                if (*matchIT == port) {
-                    matchIT = matches.erase(matchIT);
-                }
-            }
-        }
-
-        // add all non duplicates to the list
-        allPorts.insert(allPorts.end(), matches.begin(), matches.end());
+    // this uses the cache of the shared index if somebody keeps it alive, otherwise the devices are scanned once
+    try {
+        return RS232_portIndex::listPortPaths();
+    } catch (...) {
+        return {};
     }
-
-    return allPorts;
 }
 
 std::tuple<unsigned char, int> sakurajin::native::ReadNextChar(const std::shared_ptr<RS232_native>& transferDevice) {
@@ -88,7 +170,13 @@ std::tuple<std::string, int> sakurajin::native::ReadUntil(const std::shared_ptr<
     return sakurajin::native::ReadUntil(transferDevice, conditions, 1us, true);
 }
 
-int sakurajin::native::Print(const std::shared_ptr<RS232_native>& transferDevice, const std::string& text) {
+int sakurajin::native::Print(const std::shared_ptr<RS232_native>& transferDevice, std::string_view text) {
+    return PrintSegments(transferDevice, &text, 1);
+}
+
+int sakurajin::native::PrintSegments(const std::shared_ptr<RS232_native>& transferDevice,
+                                     const std::string_view*              segments,
+                                     size_t                               count) {
 
     if (transferDevice == nullptr) {
         return -1;
@@ -98,17 +186,49 @@ int sakurajin::native::Print(const std::shared_ptr<RS232_native>& transferDevice
         return -2;
     }
 
-    for (auto c : text) {
-        // retry each character until it is written
-        int64_t writeRes;
-        do {
-            writeRes = transferDevice->writeRawData(&c, 1);
+    // write as much as possible with each call and resume after partial writes
+    // the data access mutex and the connection status are only touched once per write call instead of once per character
+    size_t segment = 0;
+    size_t offset  = 0;
+    while (segment < count) {
+        // skip empty segments
+        if (segments[segment].size() == offset) {
+            segment++;
+            offset = 0;
+            continue;
+        }
+
+        int64_t writeRes = 0;
+        if (offset == 0) {
+            writeRes = transferDevice->writeSegments(segments + segment, count - segment);
+        } else {
+            // the rest of a partially written segment is written on its own, then writev continues with the next one
+            auto remaining = static_cast<int>(std::min<size_t>(segments[segment].size() - offset, INT_MAX));
+            writeRes       = transferDevice->writeRawData(segments[segment].data() + offset, remaining);
+        }
 
-            // if the connection was lost while writing, return
-            if (transferDevice->getConnectionStatus() != sakurajin::connectionStatus::connected) {
-                return -3;
+        if (writeRes > 0) {
+            // advance over all segments that were written completely
+            auto written = static_cast<size_t>(writeRes);
+            while (segment < count && written >= segments[segment].size() - offset) {
+                written -= segments[segment].size() - offset;
+                segment++;
+                offset = 0;
             }
-        } while (writeRes < 1);
+            offset += written;
+            continue;
+        }
+
+        // if the connection was lost while writing, return
+        if (transferDevice->getConnectionStatus() != sakurajin::connectionStatus::connected) {
+            return -3;
+        }
+
+        // the output queue of the device is full, wait until it can take more data instead of retrying immediately
+        ioWaitEntry entry{transferDevice.get(), ioWritable};
+        if (waitForEvents(&entry, 1, nullptr, 100ms) < 0 || (entry.returned & ioError) != 0) {
+            return -3;
+        }
     }
 
     return 0;
@@ -1,10 +1,27 @@
 ﻿#include "rs232_native.hpp"
+#include "rs232_portindex.hpp"
 
+#include <cerrno>
 #include <climits>
+#include <cstdlib>
 
+#include <dirent.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <fstream>
+
+#ifdef __linux__
+    #include <linux/serial.h>
+    #include <sys/eventfd.h>
+
+// implemented in rs232_native_termios2.cpp, since the kernel header for termios2 conflicts with termios.h
+// if bitsPerSecond is 0 the current rate is only read
+int applyTermios2Bitrate(int port, uint32_t bitsPerSecond, uint32_t& appliedRate) noexcept;
+#endif
+
 inline int& getPort(void* portHandle) noexcept {
     return *static_cast<int*>(portHandle);
 }
@@ -13,6 +30,251 @@ inline struct termios& getTermios(void* termiosHandle) noexcept {
     return *static_cast<termios*>(termiosHandle);
 }
 
+// the file of the device, relative names are looked up in /dev
+inline std::filesystem::path getDevicePath(const std::string& devname) {
+    std::filesystem::path devicePath = devname;
+    if (devicePath.is_relative()) {
+        devicePath = "/dev" / devicePath;
+    }
+    return devicePath;
+}
+
+#ifdef __linux__
+// the sysfs file of the latency timer of an usb serial adapter, empty if the adapter does not have one
+// symlinks like /dev/serial/by-id/... are resolved first, since sysfs uses the name of the tty
+inline std::filesystem::path getLatencyTimerPath(const std::string& devname) {
+    std::error_code error;
+    auto            ttyPath = std::filesystem::canonical(getDevicePath(devname), error);
+    if (error) {
+        return {};
+    }
+
+    auto timerPath = std::filesystem::path{"/sys/class/tty"} / ttyPath.filename() / "device" / "latency_timer";
+    if (!std::filesystem::exists(timerPath, error)) {
+        return {};
+    }
+    return timerPath;
+}
+
+inline int readLatencyTimer(const std::filesystem::path& timerPath) {
+    std::ifstream timerFile{timerPath};
+    int           value = -1;
+    if (!(timerFile >> value)) {
+        return -1;
+    }
+    return value;
+}
+
+inline bool writeLatencyTimer(const std::filesystem::path& timerPath, int value) {
+    std::ofstream timerFile{timerPath};
+    return static_cast<bool>(timerFile << value << std::flush);
+}
+#endif
+
+// fill the termios struct with the speed and line configuration
+// returns false if the configuration is not supported
+inline bool buildTermios(struct termios& config, int speed, const sakurajin::lineConfiguration& line) noexcept {
+    config = {};
+
+    config.c_cflag = speed | CLOCAL | CREAD;
+    switch (line.dataBits) {
+        case 5:
+            config.c_cflag |= CS5;
+            break;
+        case 6:
+            config.c_cflag |= CS6;
+            break;
+        case 7:
+            config.c_cflag |= CS7;
+            break;
+        case 8:
+            config.c_cflag |= CS8;
+            break;
+        default:
+            return false;
+    }
+
+    // characters with parity or framing errors are dropped
+    config.c_iflag = IGNPAR;
+    switch (line.parity) {
+        case sakurajin::noParity:
+            break;
+        case sakurajin::oddParity:
+            config.c_cflag |= PARENB | PARODD;
+            config.c_iflag |= INPCK;
+            break;
+        case sakurajin::evenParity:
+            config.c_cflag |= PARENB;
+            config.c_iflag |= INPCK;
+            break;
+#ifdef CMSPAR
+        case sakurajin::markParity:
+            config.c_cflag |= PARENB | PARODD | CMSPAR;
+            config.c_iflag |= INPCK;
+            break;
+        case sakurajin::spaceParity:
+            config.c_cflag |= PARENB | CMSPAR;
+            config.c_iflag |= INPCK;
+            break;
+#endif
+        default:
+            return false;
+    }
+
+    if (line.stopBitCount == sakurajin::twoStopBits) {
+        config.c_cflag |= CSTOPB;
+    }
+
+    if (line.hardwareFlowControl) {
+        config.c_cflag |= CRTSCTS;
+    }
+
+    // the tty layer sends XOFF and XON itself when its input buffer fills up and drains again
+    if (line.softwareFlowControl) {
+        config.c_iflag |= IXON | IXOFF;
+    }
+    config.c_cc[VSTART] = static_cast<cc_t>(line.xonChar);
+    config.c_cc[VSTOP]  = static_cast<cc_t>(line.xoffChar);
+
+    config.c_oflag     = 0;
+    config.c_lflag     = 0;
+    config.c_cc[VMIN]  = 0; /* block until n bytes are received */
+    config.c_cc[VTIME] = 0; /* block until a timer expires (n * 100 mSec.) */
+    return true;
+}
+
+// index 0 is the end that is polled and read, index 1 the end that is written to
+// with an eventfd both entries are the same file descriptor
+inline int* getWakeupFds(void* wakeupHandle) noexcept {
+    return static_cast<int*>(wakeupHandle);
+}
+
+sakurajin::RS232_wakeup::RS232_wakeup() {
+    auto fds = new int[2]{-1, -1};
+
+#ifdef __linux__
+    fds[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    fds[1] = fds[0];
+#else
+    if (pipe(fds) == 0) {
+        for (int i = 0; i < 2; i++) {
+            fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+            fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+        }
+    }
+#endif
+
+    if (fds[0] < 0) {
+        delete[] fds;
+        throw std::runtime_error("unable to create the wakeup handle");
+    }
+
+    wakeupHandle = static_cast<void*>(fds);
+}
+
+sakurajin::RS232_wakeup::~RS232_wakeup() {
+    auto fds = getWakeupFds(wakeupHandle);
+    close(fds[0]);
+    if (fds[1] != fds[0]) {
+        close(fds[1]);
+    }
+    delete[] fds;
+}
+
+void sakurajin::RS232_wakeup::notify() noexcept {
+    // if the pipe is full the notification is already pending, so the result can be ignored
+#ifdef __linux__
+    uint64_t value = 1;
+#else
+    char value = 0;
+#endif
+    [[maybe_unused]] auto res = write(getWakeupFds(wakeupHandle)[1], &value, sizeof(value));
+}
+
+void sakurajin::RS232_wakeup::clear() noexcept {
+    // the eventfd is reset with a single read, the pipe has to be drained completely
+    char buffer[64];
+    while (read(getWakeupFds(wakeupHandle)[0], buffer, sizeof(buffer)) > 0) {
+    }
+}
+
+int sakurajin::waitForEvents(ioWaitEntry* entries, size_t entryCount, RS232_wakeup* wakeup, std::chrono::milliseconds timeout) noexcept {
+    // the poll list is reused between calls to prevent an allocation on every wait
+    thread_local std::vector<pollfd> pollList;
+
+    try {
+        pollList.resize(entryCount + 1);
+    } catch (...) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < entryCount; i++) {
+        auto& entry    = entries[i];
+        entry.returned = ioNone;
+
+        pollfd& pfd = pollList[i];
+        pfd.fd      = -1;
+        pfd.events  = 0;
+        pfd.revents = 0;
+
+        if (entry.device == nullptr || entry.requested == ioNone || entry.device->connStatus != connectionStatus::connected) {
+            continue;
+        }
+
+        // the lock makes sure the port is not closed while the file descriptor is read
+        // poll itself runs without the lock so that other threads can still access the device
+        std::shared_lock lock{entry.device->dataAccessMutex};
+        if (entry.device->portHandle == nullptr) {
+            continue;
+        }
+
+        pfd.fd = getPort(entry.device->portHandle);
+        if ((entry.requested & ioReadable) != 0) {
+            pfd.events |= POLLIN;
+        }
+        if ((entry.requested & ioWritable) != 0) {
+            pfd.events |= POLLOUT;
+        }
+    }
+
+    // a negative file descriptor is ignored by poll
+    pollfd& wakeupFd = pollList[entryCount];
+    wakeupFd.fd      = wakeup == nullptr ? -1 : getWakeupFds(wakeup->wakeupHandle)[0];
+    wakeupFd.events  = POLLIN;
+    wakeupFd.revents = 0;
+
+    int pollTimeout = timeout.count() < 0 ? -1 : static_cast<int>(std::min<int64_t>(timeout.count(), INT_MAX));
+    if (poll(pollList.data(), pollList.size(), pollTimeout) < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    if ((wakeupFd.revents & POLLIN) != 0) {
+        wakeup->clear();
+    }
+
+    int readyCount = 0;
+    for (size_t i = 0; i < entryCount; i++) {
+        auto revents = pollList[i].revents;
+        auto& entry  = entries[i];
+
+        if ((revents & POLLIN) != 0) {
+            entry.returned |= ioReadable;
+        }
+        if ((revents & POLLOUT) != 0) {
+            entry.returned |= ioWritable;
+        }
+        if ((revents & (POLLERR | POLLHUP | POLLNVAL)) != 0) {
+            entry.returned |= ioError;
+        }
+
+        if (entry.returned != ioNone) {
+            readyCount++;
+        }
+    }
+
+    return readyCount;
+}
+
 std::vector<std::string> sakurajin::getMatchingPorts(const std::regex& pattern) noexcept {
 
     std::vector<std::string> allPorts;
@@ -30,6 +292,120 @@ std::vector<std::string> sakurajin::getMatchingPorts(const std::regex& pattern)
     return allPorts;
 }
 
+namespace {
+    // a port name is one of these prefixes followed by a number, or by letters and digits for the call-out devices on macOS
+    struct portMatcher {
+        std::string_view prefix;
+        bool             alphanumericSuffix;
+    };
+
+    constexpr portMatcher portMatchers[] = {
+        {"ttyUSB",        false},
+        {"ttyACM",        false},
+        {"cu.",           true },
+        {"cuaU",          false},
+        {"tty.usbmodem",  false},
+        {"tty.usbserial", false},
+    };
+
+    // returns the index of the matching prefix, so the ports can be listed in the order of the prefixes, or -1 if none matches
+    int portNameRank(std::string_view name) noexcept {
+        for (int rank = 0; rank < static_cast<int>(std::size(portMatchers)); rank++) {
+            const auto& matcher = portMatchers[rank];
+            if (name.size() <= matcher.prefix.size() || name.substr(0, matcher.prefix.size()) != matcher.prefix) {
+                continue;
+            }
+
+            auto suffix = name.substr(matcher.prefix.size());
+            auto valid  = std::all_of(suffix.begin(), suffix.end(), [&matcher](char c) {
+                return (c >= '0' && c <= '9') || (matcher.alphanumericSuffix && ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')));
+            });
+            if (valid) {
+                return rank;
+            }
+        }
+        return -1;
+    }
+
+#ifdef __linux__
+    // the first line of a sysfs attribute, empty if it does not exist
+    std::string readSysfsAttribute(const std::filesystem::path& attributePath) {
+        std::ifstream attributeFile{attributePath};
+        std::string   value;
+        std::getline(attributeFile, value);
+        return value;
+    }
+
+    uint16_t readSysfsHexAttribute(const std::filesystem::path& attributePath) {
+        auto value = readSysfsAttribute(attributePath);
+        return static_cast<uint16_t>(std::strtoul(value.c_str(), nullptr, 16));
+    }
+#endif
+} // namespace
+
+void sakurajin::RS232_portIndex::scanPorts(std::vector<indexEntry>& entries) {
+    // readdir already returns the inode, so a single pass over /dev needs no further system calls per entry
+    DIR* devDir = opendir("/dev");
+    if (devDir == nullptr) {
+        return;
+    }
+
+    while (auto entry = readdir(devDir)) {
+        auto rank = portNameRank(entry->d_name);
+        if (rank < 0) {
+            continue;
+        }
+
+        indexEntry port;
+        port.info.devicePath = std::string{"/dev/"} + entry->d_name;
+        port.nodeId          = static_cast<uint64_t>(entry->d_ino);
+        port.rank            = static_cast<uint32_t>(rank);
+        entries.push_back(std::move(port));
+    }
+
+    closedir(devDir);
+}
+
+void sakurajin::RS232_portIndex::readPortInfo(portInfo& info) {
+#ifdef __linux__
+    std::error_code error;
+    auto            ttyName    = std::filesystem::path{info.devicePath}.filename();
+    auto            devicePath = std::filesystem::canonical(std::filesystem::path{"/sys/class/tty"} / ttyName / "device", error);
+    if (error) {
+        return;
+    }
+
+    auto driverPath = std::filesystem::read_symlink(devicePath / "driver", error);
+    if (!error) {
+        info.driver = driverPath.filename().string();
+    }
+
+    // the usb device is one of the parents of the tty device, depending on the driver it is one or two levels up
+    for (auto usbPath = devicePath; usbPath.has_relative_path(); usbPath = usbPath.parent_path()) {
+        if (!std::filesystem::exists(usbPath / "idVendor", error)) {
+            continue;
+        }
+
+        info.vendorId     = readSysfsHexAttribute(usbPath / "idVendor");
+        info.productId    = readSysfsHexAttribute(usbPath / "idProduct");
+        info.serialNumber = readSysfsAttribute(usbPath / "serial");
+        info.manufacturer = readSysfsAttribute(usbPath / "manufacturer");
+        info.product      = readSysfsAttribute(usbPath / "product");
+        break;
+    }
+
+    for (const auto& link : std::filesystem::directory_iterator("/dev/serial/by-id", error)) {
+        if (std::filesystem::canonical(link.path(), error) == info.devicePath) {
+            info.byIdPath = link.path().string();
+            break;
+        }
+    }
+#else
+    // there is no sysfs on the other unix systems, only the device path is known
+    (void)info;
+#endif
+}
+
 sakurajin::connectionStatus sakurajin::RS232_native::connect(std::ostream& error_stream) noexcept {
     if (connStatus == connectionStatus::connected) {
         return connStatus;
@@ -38,14 +414,18 @@ sakurajin::connectionStatus sakurajin::RS232_native::connect(std::ostream& error
     // make sure no read or write operation is performed while the port is being opened
     std::scoped_lock lock{dataAccessMutex};
 
-    // convert the baudrate to int
-    int baudr = baudrate;
+    // another thread might have opened the port while this one waited for the lock
+    if (connStatus == connectionStatus::connected || portHandle != nullptr) {
+        return connStatus;
+    }
+
+    bool settingsRejected = false;
+    return openPort(error_stream, settingsRejected);
+}
 
+sakurajin::connectionStatus sakurajin::RS232_native::openPort(std::ostream& error_stream, bool& settingsRejected) noexcept {
     // check if the file for the port exists
-    std::filesystem::path devicePath = devname;
-    if (devicePath.is_relative()) {
-        devicePath = "/dev" / devicePath;
-    }
+    auto devicePath = getDevicePath(devname);
 
     // if the file does not exist, return an error
     if (!std::filesystem::exists(devicePath)) {
@@ -55,45 +435,93 @@ sakurajin::connectionStatus sakurajin::RS232_native::connect(std::ostream& error
     }
 
     // open the port and return an error if that fails
-    portHandle          = static_cast<void*>(new int{});
-    getPort(portHandle) = open(devicePath.string().c_str(), O_RDWR | O_NOCTTY | O_NDELAY);
-    if (getPort(portHandle) < 0) {
+    int port = open(devicePath.string().c_str(), O_RDWR | O_NOCTTY | O_NDELAY);
+    if (port < 0) {
         error_stream << "unable to open device port " << devicePath << std::endl;
         connStatus = connectionStatus::otherError;
         return connStatus;
     }
 
-    // get the current port settings and return an error if that fails
-    portConfig = static_cast<void*>(new termios{});
-    int error  = tcgetattr(getPort(portHandle), &getTermios(portConfig));
-    if (error < 0) {
-        close(getPort(portHandle));
+    // get the current port settings, they are restored when the port is closed
+    struct termios originalConfig {};
+
+    if (tcgetattr(port, &originalConfig) < 0) {
+        close(port);
         error_stream << "unable to read port settings for " << devicePath << std::endl;
         connStatus = connectionStatus::otherError;
         return connStatus;
     }
 
-    struct termios nps {};
-
-    nps.c_cflag     = baudr | CS8 | CLOCAL | CREAD;
-    nps.c_iflag     = IGNPAR;
-    nps.c_oflag     = 0;
-    nps.c_lflag     = 0;
-    nps.c_cc[VMIN]  = 0; /* block until n bytes are received */
-    nps.c_cc[VTIME] = 0; /* block until a timer expires (n * 100 mSec.) */
-
-    error = tcsetattr(getPort(portHandle), TCSANOW, &nps);
-    if (error < 0) {
-        close(getPort(portHandle));
-        error_stream << "unable to adjust port settings for " << devicePath << std::endl;
-        connStatus = connectionStatus::otherError;
+    portHandle = static_cast<void*>(new int{port});
+    portConfig = static_cast<void*>(new termios{originalConfig});
+
+    if (!applyPortSettings(error_stream)) {
+        close(port);
+        delete &getPort(portHandle);
+        delete &getTermios(portConfig);
+        portHandle       = nullptr;
+        portConfig       = nullptr;
+        connStatus       = connectionStatus::otherError;
+        settingsRejected = true;
         return connStatus;
     }
 
+    // failing to reduce the latency is reported but the port is still usable
+    if (lowLatency) {
+        applyLatencySettings(error_stream);
+    }
+
     connStatus = connectionStatus::connected;
     return connStatus;
 }
 
+bool sakurajin::RS232_native::applyPortSettings(std::ostream& error_stream) noexcept {
+    struct termios nps {};
+
+    if (!buildTermios(nps, baudrate, lineConfig)) {
+        error_stream << "the line configuration for " << devname << " is not supported" << std::endl;
+        return false;
+    }
+
+#ifndef __linux__
+    // the speed values of the other unix systems are plain numbers, so any rate can be passed directly
+    if (customBaudrate != 0) {
+        cfsetspeed(&nps, customBaudrate);
+    }
+#endif
+
+    // received data stays in the input queue, the pending output was already drained by reconfigure
+    if (tcsetattr(getPort(portHandle), TCSANOW, &nps) < 0) {
+        error_stream << "unable to adjust port settings for " << devname << std::endl;
+        return false;
+    }
+
+    // apply the custom rate (on linux) and read back the rate the driver actually uses
+    uint32_t actualRate = 0;
+#ifdef __linux__
+    int error = applyTermios2Bitrate(getPort(portHandle), customBaudrate, actualRate);
+#else
+    struct termios appliedConfig {};
+
+    int error  = tcgetattr(getPort(portHandle), &appliedConfig);
+    actualRate = static_cast<uint32_t>(cfgetospeed(&appliedConfig));
+#endif
+    if (error < 0 && customBaudrate != 0) {
+        error_stream << "unable to set the bit rate " << customBaudrate << " for " << devname << std::endl;
+        return false;
+    }
+
+    appliedBaudrate = error < 0 ? 0 : actualRate;
+    return true;
+}
+
+int64_t sakurajin::RS232_native::pendingOutput() noexcept {
+    return callWithOptionalLock(nullptr, [this]() {
+        int queued = 0;
+        return ioctl(getPort(portHandle), TIOCOUTQ, &queued) < 0 ? -1 : queued;
+    });
+}
+
 int64_t sakurajin::RS232_native::readRawData(char* data_location, int length, bool block) noexcept {
     if (connStatus != connectionStatus::connected) {
         return -1;
@@ -108,17 +536,36 @@ int64_t sakurajin::RS232_native::readRawData(char* data_location, int length, bo
 
     length = std::clamp(length, 0, limit);
 
-    return callWithOptionalLock<ssize_t>([this, data_location, length]() { return read(getPort(portHandle), data_location, length); },
-                                         block);
+    return callWithOptionalLock(
+        &readMutex, [this, data_location, length]() { return read(getPort(portHandle), data_location, length); }, block);
 }
 
-int64_t sakurajin::RS232_native::writeRawData(char* data_location, int length, bool block) noexcept {
+int64_t sakurajin::RS232_native::writeRawData(const char* data_location, int length, bool block) noexcept {
     if (connStatus != connectionStatus::connected) {
         return -1;
     }
 
-    return callWithOptionalLock<ssize_t>([this, data_location, length]() { return write(getPort(portHandle), data_location, length); },
-                                         block);
+    return callWithOptionalLock(
+        &writeMutex, [this, data_location, length]() { return write(getPort(portHandle), data_location, length); }, block);
+}
+
+int64_t sakurajin::RS232_native::writeSegments(const std::string_view* segments, size_t count, bool block) noexcept {
+    if (connStatus != connectionStatus::connected) {
+        return -1;
+    }
+
+    // the io vectors live on the stack, more segments than fit are written by the next call
+    constexpr size_t maxSegments = 64;
+    iovec            vectors[maxSegments];
+
+    auto vectorCount = static_cast<int>(std::min(count, maxSegments));
+    for (int i = 0; i < vectorCount; i++) {
+        vectors[i].iov_base = const_cast<char*>(segments[i].data());
+        vectors[i].iov_len  = segments[i].size();
+    }
+
+    return callWithOptionalLock(
+        &writeMutex, [this, &vectors, vectorCount]() { return writev(getPort(portHandle), vectors, vectorCount); }, block);
 }
 
 void sakurajin::RS232_native::disconnect() noexcept {
@@ -129,11 +576,39 @@ void sakurajin::RS232_native::disconnect() noexcept {
     // lock the mutex to make sure the port is not accessed while it is being closed
     std::scoped_lock lock(dataAccessMutex);
 
-    connStatus = connectionStatus::disconnected;
+    // another thread might have closed the port while this one waited for the lock
+    if (connStatus != connectionStatus::connected || portHandle == nullptr) {
+        return;
+    }
+
+    connStatus      = connectionStatus::disconnected;
+    appliedBaudrate = 0;
 
-    // close the port handles
-    close(getPort(portHandle));
+#ifdef __linux__
+    // the low latency settings stay active after the port is closed, so the ones from before the connect are restored.
+    // This fails silently if the device was removed, the next connect reads the settings again anyway.
+    if (originalLowLatencyFlag >= 0) {
+        struct serial_struct serialInfo {};
+
+        if (ioctl(getPort(portHandle), TIOCGSERIAL, &serialInfo) == 0) {
+            serialInfo.flags = (serialInfo.flags & ~ASYNC_LOW_LATENCY) | originalLowLatencyFlag;
+            ioctl(getPort(portHandle), TIOCSSERIAL, &serialInfo);
+        }
+        originalLowLatencyFlag = -1;
+    }
+
+    if (originalLatencyTimer >= 0) {
+        auto timerPath = getLatencyTimerPath(devname);
+        if (!timerPath.empty()) {
+            writeLatencyTimer(timerPath, originalLatencyTimer);
+        }
+        originalLatencyTimer = -1;
+    }
+#endif
+
+    // restore the original settings while the port is still open and close it afterwards
     tcsetattr(getPort(portHandle), TCSANOW, &getTermios(portConfig));
+    close(getPort(portHandle));
 
     // free the memory and set the pointers to nullptr
     delete &getPort(portHandle);
@@ -147,7 +622,8 @@ int64_t sakurajin::RS232_native::retrieveFlags(bool block) noexcept {
         return -1;
     }
 
-    return callWithOptionalLock<ssize_t>(
+    return callWithOptionalLock(
+        nullptr,
         [this]() {
             int64_t status;
             if (ioctl(getPort(portHandle), TIOCMGET, &status) < 0) {
@@ -157,3 +633,84 @@ int64_t sakurajin::RS232_native::retrieveFlags(bool block) noexcept {
         },
         block);
 }
+
+bool sakurajin::RS232_native::applyLatencySettings(std::ostream& error_stream) noexcept {
+#ifdef __linux__
+    bool success = true;
+
+    // let the tty layer pass received data to the reader immediately
+    struct serial_struct serialInfo {};
+
+    if (ioctl(getPort(portHandle), TIOCGSERIAL, &serialInfo) == 0) {
+        if (lowLatency && originalLowLatencyFlag < 0) {
+            originalLowLatencyFlag = serialInfo.flags & ASYNC_LOW_LATENCY;
+        }
+
+        // restore the previous flag if the low latency mode is disabled
+        serialInfo.flags &= ~ASYNC_LOW_LATENCY;
+        serialInfo.flags |= lowLatency ? ASYNC_LOW_LATENCY : std::max(originalLowLatencyFlag, 0);
+        if (!lowLatency) {
+            originalLowLatencyFlag = -1;
+        }
+
+        if (ioctl(getPort(portHandle), TIOCSSERIAL, &serialInfo) < 0) {
+            error_stream << "unable to change the low latency flag of " << devname << std::endl;
+            success = false;
+        }
+    } else if (lowLatency) {
+        error_stream << "the driver of " << devname << " does not support the low latency flag" << std::endl;
+        success = false;
+    }
+
+    // usb serial adapters collect data until their latency timer expires, this timer is only exposed in sysfs
+    auto timerPath = getLatencyTimerPath(devname);
+    if (timerPath.empty()) {
+        return success;
+    }
+
+    if (lowLatency && originalLatencyTimer < 0) {
+        originalLatencyTimer = readLatencyTimer(timerPath);
+    }
+
+    // restore the previous timer if the low latency mode is disabled
+    int timerValue = lowLatency ? lowLatencyTimer.load() : originalLatencyTimer;
+    if (timerValue >= 0 && !writeLatencyTimer(timerPath, timerValue)) {
+        error_stream << "unable to write the latency timer " << timerPath << std::endl;
+        success = false;
+    }
+
+    if (!lowLatency) {
+        originalLatencyTimer = -1;
+    }
+
+    return success;
+#else
+    if (lowLatency) {
+        error_stream << "low latency mode is only supported on linux" << std::endl;
+        return false;
+    }
+    return true;
+#endif
+}
+
+sakurajin::latencyInfo sakurajin::RS232_native::getLatencyInfo() noexcept {
+    latencyInfo info;
+
+#ifdef __linux__
+    callWithOptionalLock(nullptr, [this, &info]() {
+        struct serial_struct serialInfo {};
+
+        if (ioctl(getPort(portHandle), TIOCGSERIAL, &serialInfo) == 0) {
+            info.lowLatency = (serialInfo.flags & ASYNC_LOW_LATENCY) != 0;
+        }
+        return 0;
+    });
+
+    auto timerPath = getLatencyTimerPath(devname);
+    if (!timerPath.empty() && connStatus == connectionStatus::connected) {
+        info.latencyTimer = readLatencyTimer(timerPath);
+    }
+#endif
+
+    return info;
+}
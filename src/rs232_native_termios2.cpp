@@ -0,0 +1,34 @@
+// This file is only compiled on linux.
+// The kernel header that defines termios2 redefines struct termios, so it cannot be included in the same file as termios.h.
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+
+#include <cstdint>
+
+int applyTermios2Bitrate(int port, uint32_t bitsPerSecond, uint32_t& appliedRate) noexcept {
+    struct termios2 config {};
+
+    if (ioctl(port, TCGETS2, &config) < 0) {
+        return -1;
+    }
+
+    // replace the speed bits of both directions with BOTHER and pass the rate as plain number
+    if (bitsPerSecond != 0) {
+        config.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+        config.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+        config.c_ispeed = bitsPerSecond;
+        config.c_ospeed = bitsPerSecond;
+
+        if (ioctl(port, TCSETS2, &config) < 0) {
+            return -1;
+        }
+
+        // read the settings back, the driver stores the rate it actually uses
+        if (ioctl(port, TCGETS2, &config) < 0) {
+            return -1;
+        }
+    }
+
+    appliedRate = config.c_ospeed;
+    return 0;
+}
@@ -1,8 +1,10 @@
 #include "rs232_native.hpp"
+#include "rs232_portindex.hpp"
 
 #include "windows.h"
 
 #include <codecvt>
+#include <cstring>
 #include <locale>
 
 static inline std::string wstrToStr(const std::wstring& wideStr) noexcept {
@@ -30,13 +32,95 @@ inline DCB& getDCB(void* DCBHandle) noexcept {
     return *static_cast<DCB*>(DCBHandle);
 }
 
+sakurajin::RS232_wakeup::RS232_wakeup() {
+    // a manual reset event, so the notification stays pending until clear is called
+    auto event = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (event == NULL) {
+        throw std::runtime_error("unable to create the wakeup handle");
+    }
+
+    wakeupHandle = static_cast<void*>(new HANDLE{event});
+}
+
+sakurajin::RS232_wakeup::~RS232_wakeup() {
+    CloseHandle(getCport(wakeupHandle));
+    delete &getCport(wakeupHandle);
+}
+
+void sakurajin::RS232_wakeup::notify() noexcept {
+    SetEvent(getCport(wakeupHandle));
+}
+
+void sakurajin::RS232_wakeup::clear() noexcept {
+    ResetEvent(getCport(wakeupHandle));
+}
+
+int sakurajin::waitForEvents(ioWaitEntry* entries, size_t entryCount, RS232_wakeup* wakeup, std::chrono::milliseconds timeout) noexcept {
+    auto startTime = std::chrono::steady_clock::now();
+
+    while (true) {
+        int readyCount = 0;
+        for (size_t i = 0; i < entryCount; i++) {
+            auto& entry    = entries[i];
+            entry.returned = ioNone;
+
+            if (entry.device == nullptr || entry.requested == ioNone || entry.device->connStatus != connectionStatus::connected) {
+                continue;
+            }
+
+            std::shared_lock lock{entry.device->dataAccessMutex};
+            if (entry.device->portHandle == nullptr) {
+                continue;
+            }
+
+            // the serial port is opened without overlapped io so only the queue sizes can be checked
+            DWORD   errors;
+            COMSTAT status;
+            if (!ClearCommError(getCport(entry.device->portHandle), &errors, &status)) {
+                entry.returned = ioError;
+            } else {
+                if ((entry.requested & ioReadable) != 0 && status.cbInQue > 0) {
+                    entry.returned |= ioReadable;
+                }
+                // while the output is held by flow control a write would only run into its timeout
+                bool outputHeld = status.fCtsHold || status.fDsrHold || status.fRlsdHold || status.fXoffHold;
+                if ((entry.requested & ioWritable) != 0 && !outputHeld) {
+                    entry.returned |= ioWritable;
+                }
+            }
+
+            if (entry.returned != ioNone) {
+                readyCount++;
+            }
+        }
+
+        if (readyCount > 0) {
+            return readyCount;
+        }
+
+        // wait for the wakeup in 1ms steps and check the devices again after each step
+        if (wakeup != nullptr) {
+            if (WaitForSingleObject(getCport(wakeup->wakeupHandle), 1) == WAIT_OBJECT_0) {
+                wakeup->clear();
+                return 0;
+            }
+        } else {
+            Sleep(1);
+        }
+
+        if (timeout.count() >= 0 && std::chrono::steady_clock::now() - startTime >= timeout) {
+            return 0;
+        }
+    }
+}
+
 std::vector<std::string> sakurajin::getMatchingPorts(const std::regex& pattern) noexcept {
     std::vector<std::string> allPorts;
     wchar_t                  lpTargetPath[5000];
 
     for (uint8_t i = 0; i < 255; i++) {
         std::wstringstream wss;
-        wss << "\\\\.\\COM" << i;
+        wss << "\\\\.\\COM" << static_cast<int>(i);
         DWORD res = QueryDosDeviceW(wss.str().c_str(), lpTargetPath, 5000);
 
         // Test the return value and error if any
@@ -45,7 +129,6 @@ std::vector<std::string> sakurajin::getMatchingPorts(const std::regex& pattern)
             if (std::regex_match(narrowString, pattern)) {
                 allPorts.push_back(narrowString);
             }
-            std::cout << narrowString << ": " << lpTargetPath << std::endl;
         }
     }
 
@@ -53,6 +136,39 @@ std::vector<std::string> sakurajin::getMatchingPorts(const std::regex& pattern)
     return allPorts;
 }
 
+void sakurajin::RS232_portIndex::scanPorts(std::vector<indexEntry>& entries) {
+    // without a device name QueryDosDevice lists all dos devices at once, which is a single call instead of one per COM port
+    std::vector<char> deviceNames(16384);
+    while (QueryDosDeviceA(nullptr, deviceNames.data(), static_cast<DWORD>(deviceNames.size())) == 0) {
+        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || deviceNames.size() >= 1024 * 1024) {
+            return;
+        }
+        deviceNames.resize(deviceNames.size() * 2);
+    }
+
+    // the names are separated by null characters and the list ends with an empty name
+    for (const char* name = deviceNames.data(); *name != '\0'; name += std::strlen(name) + 1) {
+        std::string_view deviceName{name};
+        if (deviceName.size() <= 3 || deviceName.substr(0, 3) != "COM") {
+            continue;
+        }
+
+        auto number = deviceName.substr(3);
+        if (!std::all_of(number.begin(), number.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            continue;
+        }
+
+        indexEntry port;
+        port.info.devicePath = std::string{"\\\\.\\"} + name;
+        entries.push_back(std::move(port));
+    }
+}
+
+void sakurajin::RS232_portIndex::readPortInfo(portInfo& info) {
+    // reading the usb metadata needs the setup api, so only the device path is known for now
+    (void)info;
+}
+
 sakurajin::connectionStatus sakurajin::RS232_native::connect(std::ostream& error_stream) noexcept {
     if (connStatus == connectionStatus::connected) {
         return connStatus;
@@ -60,53 +176,59 @@ sakurajin::connectionStatus sakurajin::RS232_native::connect(std::ostream& error
 
     std::scoped_lock lock{dataAccessMutex};
 
-    std::stringstream baudr_conf;
-    baudr_conf << "baud=" << baudrate << " data=8 parity=N stop=1";
-
-    portHandle           = static_cast<void*>(new HANDLE{});
-    getCport(portHandle) = CreateFileA(devname.c_str(),
-                                       GENERIC_READ | GENERIC_WRITE,
-                                       0,    /* no share  */
-                                       NULL, /* no security */
-                                       OPEN_EXISTING,
-                                       0,   /* no threads */
-                                       NULL /* no templates */
+    // another thread might have opened the port while this one waited for the lock
+    if (connStatus == connectionStatus::connected || portHandle != nullptr) {
+        return connStatus;
+    }
+
+    bool settingsRejected = false;
+    return openPort(error_stream, settingsRejected);
+}
+
+sakurajin::connectionStatus sakurajin::RS232_native::openPort(std::ostream& error_stream, bool& settingsRejected) noexcept {
+    HANDLE port = CreateFileA(devname.c_str(),
+                              GENERIC_READ | GENERIC_WRITE,
+                              0,    /* no share  */
+                              NULL, /* no security */
+                              OPEN_EXISTING,
+                              0,   /* no threads */
+                              NULL /* no templates */
     );
 
-    if (getCport(portHandle) == INVALID_HANDLE_VALUE) {
+    if (port == INVALID_HANDLE_VALUE) {
         error_stream << "unable to open comport " << devname << " message:" << GetLastError() << std::endl;
         connStatus = connectionStatus::portNotFound;
         return connStatus;
     }
 
+    portHandle                   = static_cast<void*>(new HANDLE{port});
     portConfig                   = static_cast<void*>(new DCB{});
     getDCB(portConfig).DCBlength = sizeof(DCB);
 
-    if (!BuildCommDCBA(baudr_conf.str().c_str(), &getDCB(portConfig))) {
-        error_stream << "unable to set comport dcb settings for " << devname << std::endl;
-        CloseHandle(getCport(portHandle));
-        connStatus = connectionStatus::otherError;
-        return connStatus;
-    }
-
-    if (!SetCommState(getCport(portHandle), &getDCB(portConfig))) {
-        error_stream << "unable to set comport cfg settings for " << devname << std::endl;
-        CloseHandle(getCport(portHandle));
-        connStatus = connectionStatus::otherError;
-        return connStatus;
-    }
-
+    // reads return immediately with the data that is available.
+    // There is no such setting for writes, a zero timeout would even wait forever if the output is stopped by flow control.
+    // The shortest possible timeout makes WriteFile return after about 1ms with the number of bytes that were accepted.
     COMMTIMEOUTS Cptimeouts;
 
     Cptimeouts.ReadIntervalTimeout         = MAXDWORD;
     Cptimeouts.ReadTotalTimeoutMultiplier  = 0;
     Cptimeouts.ReadTotalTimeoutConstant    = 0;
     Cptimeouts.WriteTotalTimeoutMultiplier = 0;
-    Cptimeouts.WriteTotalTimeoutConstant   = 0;
+    Cptimeouts.WriteTotalTimeoutConstant   = 1;
 
-    if (!SetCommTimeouts(getCport(portHandle), &Cptimeouts)) {
+    bool success     = applyPortSettings(error_stream);
+    settingsRejected = !success;
+    if (success && !SetCommTimeouts(port, &Cptimeouts)) {
         error_stream << "unable to set comport time-out settings for " << devname << std::endl;
-        CloseHandle(getCport(portHandle));
+        success = false;
+    }
+
+    if (!success) {
+        CloseHandle(port);
+        delete &getCport(portHandle);
+        delete &getDCB(portConfig);
+        portHandle = nullptr;
+        portConfig = nullptr;
         connStatus = connectionStatus::otherError;
         return connStatus;
     }
@@ -115,6 +237,55 @@ sakurajin::connectionStatus sakurajin::RS232_native::connect(std::ostream& error
     return connStatus;
 }
 
+bool sakurajin::RS232_native::applyPortSettings(std::ostream& error_stream) noexcept {
+    constexpr std::string_view parityNames = "NOEMS";
+
+    std::stringstream baudr_conf;
+    baudr_conf << "baud=" << baudrate << " data=" << static_cast<int>(lineConfig.dataBits);
+    baudr_conf << " parity=" << parityNames[std::min<size_t>(lineConfig.parity, parityNames.size() - 1)];
+    baudr_conf << " stop=" << (lineConfig.stopBitCount == twoStopBits ? 2 : 1);
+
+    DCB dcb{};
+    dcb.DCBlength = sizeof(DCB);
+
+    if (!BuildCommDCBA(baudr_conf.str().c_str(), &dcb)) {
+        error_stream << "unable to set comport dcb settings for " << devname << std::endl;
+        return false;
+    }
+
+    // the DCB takes the rate as plain number, so a custom rate can be set directly
+    if (customBaudrate != 0) {
+        dcb.BaudRate = customBaudrate;
+    }
+
+    // flow control is not part of the configuration string, so it is set in the DCB directly
+    if (lineConfig.hardwareFlowControl) {
+        dcb.fOutxCtsFlow = TRUE;
+        dcb.fRtsControl  = RTS_CONTROL_HANDSHAKE;
+    }
+    if (lineConfig.softwareFlowControl) {
+        dcb.fOutX    = TRUE;
+        dcb.fInX     = TRUE;
+        dcb.XonChar  = lineConfig.xonChar;
+        dcb.XoffChar = lineConfig.xoffChar;
+        dcb.XonLim   = lineConfig.xonLimit;
+        dcb.XoffLim  = lineConfig.xoffLimit;
+    }
+
+    // received data stays in the input queue, the pending output was already drained by reconfigure
+    if (!SetCommState(getCport(portHandle), &dcb)) {
+        error_stream << "unable to set comport cfg settings for " << devname << std::endl;
+        return false;
+    }
+    getDCB(portConfig) = dcb;
+
+    // read back the rate the driver actually uses
+    DCB appliedConfig{};
+    appliedConfig.DCBlength = sizeof(DCB);
+    appliedBaudrate         = GetCommState(getCport(portHandle), &appliedConfig) ? appliedConfig.BaudRate : 0;
+    return true;
+}
+
 void sakurajin::RS232_native::disconnect() noexcept {
     if (connStatus != connectionStatus::connected) {
         return;
@@ -122,6 +293,11 @@ void sakurajin::RS232_native::disconnect() noexcept {
 
     std::scoped_lock lock{dataAccessMutex};
 
+    // another thread might have closed the port while this one waited for the lock
+    if (connStatus != connectionStatus::connected || portHandle == nullptr) {
+        return;
+    }
+
     CloseHandle(getCport(portHandle));
 
     delete &getCport(portHandle);
@@ -129,7 +305,16 @@ void sakurajin::RS232_native::disconnect() noexcept {
     portHandle = nullptr;
     portConfig = nullptr;
 
-    connStatus = connectionStatus::disconnected;
+    connStatus      = connectionStatus::disconnected;
+    appliedBaudrate = 0;
+}
+
+int64_t sakurajin::RS232_native::pendingOutput() noexcept {
+    return callWithOptionalLock(nullptr, [this]() {
+        DWORD   errors = 0;
+        COMSTAT status{};
+        return ClearCommError(getCport(portHandle), &errors, &status) ? static_cast<int64_t>(status.cbOutQue) : -1;
+    });
 }
 
 int64_t sakurajin::RS232_native::readRawData(char* data_location, int length, bool block) noexcept {
@@ -137,7 +322,8 @@ int64_t sakurajin::RS232_native::readRawData(char* data_location, int length, bo
         return -1;
     }
 
-    return callWithOptionalLock<int64_t>(
+    return callWithOptionalLock(
+        &readMutex,
         [this, data_location, length]() {
             int  n         = 0;
             auto local_len = std::clamp(length, 0, 4096);
@@ -148,12 +334,13 @@ int64_t sakurajin::RS232_native::readRawData(char* data_location, int length, bo
         block);
 }
 
-int64_t sakurajin::RS232_native::writeRawData(char* data_location, int length, bool block) noexcept {
+int64_t sakurajin::RS232_native::writeRawData(const char* data_location, int length, bool block) noexcept {
     if (connStatus != connectionStatus::connected) {
         return -1;
     }
 
-    return callWithOptionalLock<int64_t>(
+    return callWithOptionalLock(
+        &writeMutex,
         [this, data_location, length]() {
             int  n         = 0;
             auto local_len = std::clamp(length, 0, 4096);
@@ -164,12 +351,41 @@ int64_t sakurajin::RS232_native::writeRawData(char* data_location, int length, b
         block);
 }
 
+int64_t sakurajin::RS232_native::writeSegments(const std::string_view* segments, size_t count, bool block) noexcept {
+    if (connStatus != connectionStatus::connected) {
+        return -1;
+    }
+
+    // there is no gathering write for com ports, so the segments are written one after the other while holding the lock
+    return callWithOptionalLock(
+        &writeMutex,
+        [this, segments, count]() {
+            int64_t total = 0;
+            for (size_t i = 0; i < count; i++) {
+                DWORD n         = 0;
+                auto  local_len = static_cast<DWORD>(std::min<size_t>(segments[i].size(), 4096));
+
+                if (!WriteFile(getCport(portHandle), segments[i].data(), local_len, &n, NULL)) {
+                    return total > 0 ? total : static_cast<int64_t>(-1);
+                }
+
+                total += n;
+                if (n < segments[i].size()) {
+                    break;
+                }
+            }
+            return total;
+        },
+        block);
+}
+
 int64_t sakurajin::RS232_native::retrieveFlags(bool block) noexcept {
     if (connStatus != connectionStatus::connected) {
         return -1;
     }
 
-    return callWithOptionalLock<int64_t>(
+    return callWithOptionalLock(
+        nullptr,
         [this]() {
             DWORD flags;
             if (!GetCommModemStatus(getCport(portHandle), &flags)) {
@@ -179,3 +395,16 @@ int64_t sakurajin::RS232_native::retrieveFlags(bool block) noexcept {
         },
         block);
 }
+
+bool sakurajin::RS232_native::applyLatencySettings(std::ostream& error_stream) noexcept {
+    // the latency timer of usb serial adapters can only be changed in the driver settings on windows
+    if (lowLatency) {
+        error_stream << "low latency mode is not supported on windows" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+sakurajin::latencyInfo sakurajin::RS232_native::getLatencyInfo() noexcept {
+    return {};
+}
@@ -0,0 +1,126 @@
+#include "rs232_portindex.hpp"
+
+namespace {
+    // the shared index is only kept alive by its users, so it is destroyed (and unsubscribes) once nobody needs it anymore
+    std::mutex                                sharedIndexMutex;
+    std::weak_ptr<sakurajin::RS232_portIndex> sharedIndex;
+} // namespace
+
+sakurajin::RS232_portIndex::RS232_portIndex() {
+    hotplugMonitor = RS232_hotplugMonitor::getShared();
+    if (hotplugMonitor != nullptr) {
+        hotplugMonitor->subscribe(&devicesChanged, nullptr);
+    }
+}
+
+sakurajin::RS232_portIndex::~RS232_portIndex() {
+    if (hotplugMonitor != nullptr) {
+        hotplugMonitor->unsubscribe(&devicesChanged);
+    }
+}
+
+std::shared_ptr<sakurajin::RS232_portIndex> sakurajin::RS232_portIndex::getShared() {
+    std::scoped_lock lock{sharedIndexMutex};
+
+    auto index = sharedIndex.lock();
+    if (index == nullptr) {
+        index       = std::make_shared<RS232_portIndex>();
+        sharedIndex = index;
+    }
+    return index;
+}
+
+std::vector<std::string> sakurajin::RS232_portIndex::listPortPaths() {
+    std::shared_ptr<RS232_portIndex> index;
+    {
+        std::scoped_lock lock{sharedIndexMutex};
+        index = sharedIndex.lock();
+    }
+
+    if (index != nullptr) {
+        return index->getPortPaths();
+    }
+
+    // a single scan does not need the metadata of the ports
+    std::vector<indexEntry> scanned;
+    scanPorts(scanned);
+    std::sort(scanned.begin(), scanned.end(), entryBefore);
+
+    std::vector<std::string> paths;
+    paths.reserve(scanned.size());
+    for (auto& entry : scanned) {
+        paths.push_back(std::move(entry.info.devicePath));
+    }
+    return paths;
+}
+
+bool sakurajin::RS232_portIndex::entryBefore(const indexEntry& lhs, const indexEntry& rhs) noexcept {
+    if (lhs.rank != rhs.rank) {
+        return lhs.rank < rhs.rank;
+    }
+    return lhs.info.devicePath < rhs.info.devicePath;
+}
+
+void sakurajin::RS232_portIndex::update() {
+    // without a monitor there is no way to know if something changed, so the devices are scanned every time
+    if (hotplugMonitor != nullptr && !devicesChanged.exchange(false)) {
+        return;
+    }
+
+    std::vector<indexEntry> scanned;
+    scanPorts(scanned);
+    std::sort(scanned.begin(), scanned.end(), entryBefore);
+
+    // both lists are sorted, so a single merge pass finds the new, the replaced and the removed ports
+    auto knownIT = ports.begin();
+    for (auto& entry : scanned) {
+        while (knownIT != ports.end() && entryBefore(*knownIT, entry)) {
+            knownIT++;
+        }
+
+        if (knownIT != ports.end() && knownIT->info.devicePath == entry.info.devicePath && knownIT->nodeId == entry.nodeId) {
+            entry.info = std::move(knownIT->info);
+            knownIT++;
+            continue;
+        }
+
+        readPortInfo(entry.info);
+    }
+
+    ports = std::move(scanned);
+}
+
+void sakurajin::RS232_portIndex::refresh() {
+    std::scoped_lock lock{indexMutex};
+    update();
+}
+
+std::vector<sakurajin::portInfo> sakurajin::RS232_portIndex::getPorts() {
+    return collectPorts([](const portInfo&) { return true; });
+}
+
+std::vector<std::string> sakurajin::RS232_portIndex::getPortPaths() {
+    std::scoped_lock lock{indexMutex};
+    update();
+
+    std::vector<std::string> paths;
+    paths.reserve(ports.size());
+    for (const auto& entry : ports) {
+        paths.push_back(entry.info.devicePath);
+    }
+    return paths;
+}
+
+std::vector<sakurajin::portInfo> sakurajin::RS232_portIndex::findByUsbId(uint16_t vendorId, uint16_t productId) {
+    return collectPorts([vendorId, productId](const portInfo& info) {
+        return info.vendorId == vendorId && (productId == 0 || info.productId == productId);
+    });
+}
+
+std::vector<sakurajin::portInfo> sakurajin::RS232_portIndex::findBySerialNumber(std::string_view serialNumber) {
+    return collectPorts([serialNumber](const portInfo& info) { return !info.serialNumber.empty() && info.serialNumber == serialNumber; });
+}
+
+std::vector<sakurajin::portInfo> sakurajin::RS232_portIndex::findByDriver(std::string_view driver) {
+    return collectPorts([driver](const portInfo& info) { return !info.driver.empty() && info.driver == driver; });
+}
@@ -0,0 +1,154 @@
+#include "rs232.hpp"
+
+using namespace std::literals;
+
+sakurajin::RS232_reactor::RS232_reactor(size_t threadCount) {
+    threadCount = std::max<size_t>(threadCount, 1);
+
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        workers.emplace_back(std::make_unique<worker>());
+    }
+
+    // only start the threads once all workers exist
+    for (auto& self : workers) {
+        self->thread = std::async(std::launch::async, [this, &self = *self]() {
+            while (!stopThreads) {
+                run(self);
+            }
+        });
+    }
+}
+
+sakurajin::RS232_reactor::~RS232_reactor() {
+    stopThreads = true;
+    for (auto& self : workers) {
+        self->wakeup.notify();
+    }
+
+    for (auto& self : workers) {
+        if (self->thread.valid()) {
+            self->thread.wait();
+        }
+    }
+}
+
+void sakurajin::RS232_reactor::run(worker& self) {
+    // these are only used by this thread and reused for every call to keep their capacity
+    thread_local std::vector<registration>                  instances;
+    thread_local std::vector<std::shared_ptr<RS232_native>> devices;
+    thread_local std::vector<ioWaitEntry>                   entries;
+    thread_local std::vector<size_t>                        indices;
+    thread_local std::vector<size_t>                        firstEntries;
+
+    instances.clear();
+    devices.clear();
+    entries.clear();
+    indices.clear();
+    firstEntries.clear();
+
+    // collect what every object wants to wait for
+    auto   timeout = 100ms;
+    size_t generation;
+    {
+        std::scoped_lock lock{self.instanceMutex};
+        generation = self.generation;
+
+        for (const auto& registered : self.instances) {
+            auto                          instance = registered.instance;
+            std::shared_ptr<RS232_native> device;
+            ioWaitEntry                   entry;
+
+            timeout = std::min(timeout, instance->prepareWait(device, entry, ioReadable | ioWritable));
+            instances.push_back(registered);
+            devices.push_back(std::move(device));
+            firstEntries.push_back(entries.size());
+            entries.push_back(entry);
+            indices.push_back(instance->currentDevice);
+
+            // every object has one entry for its current device followed by the entries for its broadcast messages
+            instance->prepareBroadcastWait(indices, entries);
+        }
+    }
+
+    // the wait is done without the lock, so objects can be added or removed in the meantime
+    if (waitForEvents(entries.data(), entries.size(), &self.wakeup, timeout) < 0) {
+        std::cerr << "Error while waiting for the devices of the reactor" << std::endl;
+        return;
+    }
+
+    // the lock is held while handling the events, this way removeInstance waits until the object is not used anymore
+    std::scoped_lock lock{self.instanceMutex};
+    for (size_t i = 0; i < instances.size(); i++) {
+        // skip objects that were removed during the wait, a new object might have been added at the same address
+        if (generation != self.generation) {
+            auto instanceIT = std::find_if(self.instances.begin(), self.instances.end(), [id = instances[i].id](const registration& known) {
+                return known.id == id;
+            });
+            if (instanceIT == self.instances.end()) {
+                continue;
+            }
+        }
+
+        auto instance = instances[i].instance;
+        auto first    = firstEntries[i];
+        auto last     = i + 1 < instances.size() ? firstEntries[i + 1] : entries.size();
+        instance->handleEvents(devices[i], entries[first].returned, ioReadable | ioWritable);
+        instance->handleBroadcastEvents(indices.data() + first + 1, entries.data() + first + 1, last - first - 1);
+    }
+
+    // do not keep the devices alive until the next iteration
+    devices.clear();
+}
+
+void sakurajin::RS232_reactor::addInstance(RS232* instance) {
+    // find the thread with the least objects
+    worker* leastBusy  = nullptr;
+    size_t  leastCount = SIZE_MAX;
+    for (auto& self : workers) {
+        std::scoped_lock lock{self->instanceMutex};
+        if (self->instances.size() < leastCount) {
+            leastBusy  = self.get();
+            leastCount = self->instances.size();
+        }
+    }
+
+    // the thread may use the object as soon as it is in the list, so the object has to know the wakeup handle before
+    instance->workerWakeup = &leastBusy->wakeup;
+    instance->readerWakeup = &leastBusy->wakeup;
+    {
+        std::scoped_lock lock{leastBusy->instanceMutex};
+        leastBusy->instances.push_back(registration{instance, nextRegistrationId++});
+    }
+
+    // make the thread include the new object in its next wait
+    leastBusy->wakeup.notify();
+}
+
+void sakurajin::RS232_reactor::removeInstance(RS232* instance) {
+    for (auto& self : workers) {
+        std::scoped_lock lock{self->instanceMutex};
+
+        auto instanceIT = std::find_if(self->instances.begin(), self->instances.end(), [instance](const registration& known) {
+            return known.instance == instance;
+        });
+        if (instanceIT != self->instances.end()) {
+            self->instances.erase(instanceIT);
+            self->generation++;
+            return;
+        }
+    }
+}
+
+size_t sakurajin::RS232_reactor::getThreadCount() const noexcept {
+    return workers.size();
+}
+
+size_t sakurajin::RS232_reactor::getInstanceCount() {
+    size_t count = 0;
+    for (auto& self : workers) {
+        std::scoped_lock lock{self->instanceMutex};
+        count += self->instances.size();
+    }
+    return count;
+}
@@ -0,0 +1,76 @@
+#include "rs232_ringbuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+sakurajin::RS232_ringBuffer::RS232_ringBuffer(size_t capacity) {
+    // round up to the next power of two so the indices can be mapped with a mask
+    size_t realCapacity = 1;
+    while (realCapacity < capacity) {
+        realCapacity <<= 1;
+    }
+
+    storage = std::make_unique<char[]>(realCapacity);
+    mask    = realCapacity - 1;
+}
+
+size_t sakurajin::RS232_ringBuffer::capacity() const noexcept {
+    return mask + 1;
+}
+
+size_t sakurajin::RS232_ringBuffer::size() const noexcept {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+}
+
+bool sakurajin::RS232_ringBuffer::empty() const noexcept {
+    return size() == 0;
+}
+
+size_t sakurajin::RS232_ringBuffer::push(const char* data, size_t length) noexcept {
+    auto currentHead = head.load(std::memory_order_relaxed);
+
+    // only load the real tail if the cached one does not leave enough space
+    auto freeSpace = capacity() - (currentHead - cachedTail);
+    if (freeSpace < length) {
+        cachedTail = tail.load(std::memory_order_acquire);
+        freeSpace  = capacity() - (currentHead - cachedTail);
+    }
+
+    length = std::min(length, freeSpace);
+    if (length == 0) {
+        return 0;
+    }
+
+    // the data might wrap around the end of the storage, so it is copied in up to two parts
+    auto offset    = currentHead & mask;
+    auto firstPart = std::min(length, capacity() - offset);
+    std::memcpy(storage.get() + offset, data, firstPart);
+    std::memcpy(storage.get(), data + firstPart, length - firstPart);
+
+    head.store(currentHead + length, std::memory_order_release);
+    return length;
+}
+
+size_t sakurajin::RS232_ringBuffer::pop(char* destination, size_t length) noexcept {
+    auto currentTail = tail.load(std::memory_order_relaxed);
+
+    // only load the real head if the cached one does not provide enough data
+    auto available = cachedHead - currentTail;
+    if (available < length) {
+        cachedHead = head.load(std::memory_order_acquire);
+        available  = cachedHead - currentTail;
+    }
+
+    length = std::min(length, available);
+    if (length == 0) {
+        return 0;
+    }
+
+    auto offset    = currentTail & mask;
+    auto firstPart = std::min(length, capacity() - offset);
+    std::memcpy(destination, storage.get() + offset, firstPart);
+    std::memcpy(destination + firstPart, storage.get(), length - firstPart);
+
+    tail.store(currentTail + length, std::memory_order_release);
+    return length;
+}
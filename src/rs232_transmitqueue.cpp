@@ -0,0 +1,190 @@
+#include "rs232_transmitqueue.hpp"
+
+// The queue itself is the intrusive mpsc queue by Dmitry Vyukov.
+// Producers only do a single exchange on head, the consumer walks the list from the tail.
+sakurajin::RS232_transmitQueue::RS232_transmitQueue()
+    : head(&stub),
+      tail(&stub) {}
+
+sakurajin::RS232_transmitQueue::~RS232_transmitQueue() {
+    // no producer can be active anymore, so every node is either in the queue or in the free list
+    for (auto oldNode = popNode(); oldNode != nullptr; oldNode = popNode()) {
+        delete oldNode;
+    }
+
+    auto freeNode = freeList.load();
+    while (freeNode != nullptr) {
+        auto nextNode = freeNode->nextFree;
+        delete freeNode;
+        freeNode = nextNode;
+    }
+}
+
+sakurajin::RS232_transmitQueue::node* sakurajin::RS232_transmitQueue::acquireNode() {
+    // Take the whole free list at once. Popping a single node with compare exchange would suffer from the ABA problem
+    // since nodes are constantly recycled. Other producers see an empty list in the meantime and allocate new nodes.
+    auto freeNodes = freeList.exchange(nullptr, std::memory_order_acquire);
+    if (freeNodes == nullptr) {
+        return new node{};
+    }
+
+    // give the rest of the list back, in the common case nobody released nodes in the meantime and this is a single operation
+    auto rest = freeNodes->nextFree;
+    if (rest != nullptr) {
+        node* expected = nullptr;
+        if (!freeList.compare_exchange_strong(expected, rest, std::memory_order_release, std::memory_order_relaxed)) {
+            auto last = rest;
+            while (last->nextFree != nullptr) {
+                last = last->nextFree;
+            }
+            releaseNodes(rest, last);
+        }
+    }
+
+    freeNodes->nextFree = nullptr;
+    freeNodes->next.store(nullptr, std::memory_order_relaxed);
+    return freeNodes;
+}
+
+void sakurajin::RS232_transmitQueue::releaseNodes(node* first, node* last) noexcept {
+    // pushing onto a lock free stack is not affected by the ABA problem
+    auto currentFirst = freeList.load(std::memory_order_relaxed);
+    do {
+        last->nextFree = currentFirst;
+    } while (!freeList.compare_exchange_weak(currentFirst, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void sakurajin::RS232_transmitQueue::pushNode(node* newNode) noexcept {
+    newNode->next.store(nullptr, std::memory_order_relaxed);
+    auto previous = head.exchange(newNode, std::memory_order_acq_rel);
+    previous->next.store(newNode, std::memory_order_release);
+}
+
+sakurajin::RS232_transmitQueue::node* sakurajin::RS232_transmitQueue::popNode() noexcept {
+    auto oldest = tail;
+    auto next   = oldest->next.load(std::memory_order_acquire);
+
+    // skip the stub node
+    if (oldest == &stub) {
+        if (next == nullptr) {
+            return nullptr;
+        }
+        tail   = next;
+        oldest = next;
+        next   = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr) {
+        tail = next;
+        return oldest;
+    }
+
+    // a producer already exchanged the head but did not link its node yet
+    if (oldest != head.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    // the oldest node is the last one, put the stub back so it can be removed
+    pushNode(&stub);
+    next = oldest->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+        tail = next;
+        return oldest;
+    }
+
+    return nullptr;
+}
+
+void sakurajin::RS232_transmitQueue::push(std::string message) {
+    auto newNode = acquireNode();
+
+    // reuse the capacity of the pooled node if possible, otherwise take over the allocation of the message
+    if (message.size() <= newNode->message.capacity()) {
+        newNode->message.assign(message);
+    } else {
+        newNode->message = std::move(message);
+    }
+
+    pushNode(newNode);
+}
+
+void sakurajin::RS232_transmitQueue::pushSegments(const std::string_view* segments, size_t count) {
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        length += segments[i].size();
+    }
+
+    auto newNode = acquireNode();
+    newNode->message.reserve(length);
+    for (size_t i = 0; i < count; i++) {
+        newNode->message.append(segments[i]);
+    }
+
+    pushNode(newNode);
+}
+
+size_t sakurajin::RS232_transmitQueue::drainInto(std::string& destination, size_t maxLength) {
+    node*  firstDone = nullptr;
+    node*  lastDone  = nullptr;
+    size_t count     = 0;
+
+    while (destination.size() < maxLength) {
+        auto oldest = popNode();
+        if (oldest == nullptr) {
+            break;
+        }
+
+        destination.append(oldest->message);
+        oldest->message.clear();
+        count++;
+
+        // collect the nodes and put them back into the pool with a single operation
+        oldest->nextFree = firstDone;
+        firstDone        = oldest;
+        if (lastDone == nullptr) {
+            lastDone = oldest;
+        }
+    }
+
+    if (firstDone != nullptr) {
+        releaseNodes(firstDone, lastDone);
+    }
+
+    return count;
+}
+
+size_t sakurajin::RS232_transmitQueue::dropOldest(size_t length) {
+    node*  firstDone = nullptr;
+    node*  lastDone  = nullptr;
+    size_t dropped   = 0;
+
+    while (dropped < length) {
+        auto oldest = popNode();
+        if (oldest == nullptr) {
+            break;
+        }
+
+        dropped += oldest->message.size();
+        oldest->message.clear();
+
+        oldest->nextFree = firstDone;
+        firstDone        = oldest;
+        if (lastDone == nullptr) {
+            lastDone = oldest;
+        }
+    }
+
+    if (firstDone != nullptr) {
+        releaseNodes(firstDone, lastDone);
+    }
+
+    return dropped;
+}
+
+bool sakurajin::RS232_transmitQueue::empty() const noexcept {
+    auto oldest = tail;
+    if (oldest == &stub) {
+        return oldest->next.load(std::memory_order_acquire) == nullptr;
+    }
+    return false;
+}